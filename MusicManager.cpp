@@ -15,7 +15,7 @@
 *   - Bei Bedarf können Anführungszeichen/escaping ergänzt werden.
 *
 *  Abhängigkeiten:
-*   - <fstream>, <sstream>, <algorithm>, <iomanip> (je nach Implementierung)
+*   - <fstream>, <algorithm>, <charconv> (je nach Implementierung)
 *
 * 
 * Hinweis / Disclaimer:
@@ -28,19 +28,50 @@
 
 #include "MusicManager.hpp"
 #include <fstream>
-#include <sstream>
 #include <string>
 #include <vector>
 #include <algorithm>
 #include <cctype>
 #include <optional>
+#include <string_view>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <exception>
+#include <iterator>
+#include <cstdio>
+#include <filesystem>
+
+#include <cstdint>
+#include <climits>
+#include <cmath>
+#include <atomic>
+#include <system_error>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define MUSICMANAGER_X86_SIMD 1
+#endif
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 
 //------------------------------------- Hilfsfunktionen----------------------------------------------
 
 
-// Entfernt Leerzeichen am Anfang und Ende
-std::string trim(const std::string& s) {
+// Entfernt Leerzeichen am Anfang und Ende, liefert nur einen Ausschnitt (keine Kopie)
+static std::string_view trimView(std::string_view s) {
     size_t start = 0;
     while (start < s.size() && std::isspace(static_cast<unsigned char>(s[start]))) {
         start++;
@@ -54,201 +85,3620 @@ std::string trim(const std::string& s) {
     return s.substr(start, end - start);
 }
 
+// Entfernt Leerzeichen am Anfang und Ende
+std::string trim(const std::string& s) {
+    return std::string(trimView(s));
+}
+
 
 
-bool icontains(const std::string& text, const std::string& search) {
-    // Kopien anlegen
-    std::string t = text;
-    std::string s = search;
+//------------------------------------- Teilstring-Suche ----------------------------------------------
+// Sucht einen Suchbegriff ohne Beachtung der Groß-/Kleinschreibung (ASCII). Der Begriff
+// muss schon in Kleinbuchstaben vorliegen, der Text wird im Kern gefaltet. Die
+// SIMD-Varianten vergleichen 16/32 Startpositionen auf einmal mit dem ersten und dem
+// letzten Zeichen des Begriffs und prüfen nur dort die Mitte Zeichen für Zeichen.
 
-    // text -> lowercase
-    for (size_t i = 0; i < t.size(); ++i) {
-        unsigned char ch = static_cast<unsigned char>(t[i]);
-        t[i] = static_cast<char>(std::tolower(ch));
-    }
+// ASCII-Großbuchstaben in Kleinbuchstaben (wie std::tolower im "C"-Locale)
+static inline char foldAscii(char ch) {
+    return (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch + ('a' - 'A')) : ch;
+}
 
-    // search -> lowercase
-    for (size_t i = 0; i < s.size(); ++i) {
-        unsigned char ch = static_cast<unsigned char>(s[i]);
-        s[i] = static_cast<char>(std::tolower(ch));
+static bool hasUpperAscii(std::string_view s) {
+    for (char ch : s) {
+        if (ch >= 'A' && ch <= 'Z') return true;
     }
+    return false;
+}
 
-    // Teilstring-Suche (case-insensitiv durch die Umwandlung)
-    return t.find(s) != std::string::npos;
+static std::string foldCase(std::string_view s) {
+    std::string out(s);
+    for (auto& ch : out) ch = foldAscii(ch);
+    return out;
 }
 
+using FindFn = bool (*)(std::string_view text, std::string_view folded);
 
+// n Zeichen von text gefaltet mit folded vergleichen
+static inline bool equalsFolded(const char* text, const char* folded, size_t n) {
+    for (size_t k = 0; k < n; ++k) {
+        if (foldAscii(text[k]) != folded[k]) return false;
+    }
+    return true;
+}
 
-// CSV-Zeile in Felder aufteilen
-std::vector<std::string> splitCsv(const std::string& line) {
-    std::vector<std::string> parts;
-    std::stringstream ss(line);
-    std::string item;
+// Skalare Variante, auch für Texte mit weniger Startpositionen als ein SIMD-Block
+static bool containsFoldedScalar(std::string_view text, std::string_view folded) {
+    if (folded.empty()) return true;
+    if (folded.size() > text.size()) return false;
 
-    while (std::getline(ss, item, ',')) {
-        parts.push_back(trim(item));
+    const char first = folded[0];
+    for (size_t i = 0; i + folded.size() <= text.size(); ++i) {
+        if (foldAscii(text[i]) == first && equalsFolded(text.data() + i + 1, folded.data() + 1, folded.size() - 1)) {
+            return true;
+        }
     }
+    return false;
+}
+
+#ifdef MUSICMANAGER_X86_SIMD
 
-    return parts;
+#ifdef __SSE2__
+// 'A'..'Z' -> 'a'..'z' für 16 Bytes (v - 'A' <= 25 vorzeichenlos)
+static inline __m128i foldSse2(__m128i v) {
+    const __m128i t = _mm_sub_epi8(v, _mm_set1_epi8('A'));
+    const __m128i upper = _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8(25)), t);
+    return _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
 }
 
+static bool containsFoldedSse2(std::string_view text, std::string_view folded) {
+    const size_t m = folded.size();
+    if (m == 0) return true;
+    if (m > text.size()) return false;
 
-//--------------------------------- Methoden der MusicLibrary---------------------------------------------------
+    // Startpositionen 0 .. positions-1, zu wenige für einen Block: skalar
+    const size_t positions = text.size() - m + 1;
+    if (positions < 16) return containsFoldedScalar(text, folded);
 
-bool MusicLibrary::loadFromCsv(const std::string& path) {           //Track aus CSV Datei laden
-    clear();
-    std::ifstream file(path);
-    if (!file.is_open()) return false;
+    const char* s = text.data();
+    const __m128i first = _mm_set1_epi8(folded[0]);
+    const __m128i last = _mm_set1_epi8(folded[m - 1]);
+    const size_t middle = m > 2 ? m - 2 : 0;
+
+    // 16 Startpositionen ab i prüfen
+    auto block = [&](size_t i) {
+        __m128i a = foldSse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i)));
+        __m128i b = foldSse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + m - 1)));
+        std::uint32_t mask = static_cast<std::uint32_t>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last))));
+        while (mask) {
+            size_t pos = i + __builtin_ctz(mask);
+            if (equalsFolded(s + pos + 1, folded.data() + 1, middle)) return true;
+            mask &= mask - 1;
+        }
+        return false;
+    };
+
+    size_t i = 0;
+    for (; i + 16 <= positions; i += 16) {
+        if (block(i)) return true;
+    }
+    // Rest mit einem überlappenden letzten Block statt skalar
+    return i < positions && block(positions - 16);
+}
+#endif
+
+__attribute__((target("avx2")))
+static inline __m256i foldAvx2(__m256i v) {
+    const __m256i t = _mm256_sub_epi8(v, _mm256_set1_epi8('A'));
+    const __m256i upper = _mm256_cmpeq_epi8(_mm256_min_epu8(t, _mm256_set1_epi8(25)), t);
+    return _mm256_or_si256(v, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+}
+
+__attribute__((target("avx2")))
+static bool containsFoldedAvx2(std::string_view text, std::string_view folded) {
+    const size_t m = folded.size();
+    if (m == 0) return true;
+    if (m > text.size()) return false;
 
-    std::string header;
-    std::getline(file, header); // Kopfzeile ignorieren
+    const size_t positions = text.size() - m + 1;
+#ifdef __SSE2__
+    if (positions < 32) return containsFoldedSse2(text, folded);
+#else
+    if (positions < 32) return containsFoldedScalar(text, folded);
+#endif
 
-    std::string line;
-    while (std::getline(file, line)) {
-        line = trim(line);
-        if (line.empty()) continue;
+    const char* s = text.data();
+    const __m256i first = _mm256_set1_epi8(folded[0]);
+    const __m256i last = _mm256_set1_epi8(folded[m - 1]);
+    const size_t middle = m > 2 ? m - 2 : 0;
 
-        MusicTrack track;
-        if (fromCsvRow(line, track)) {
-            tracks_.push_back(track);
+    // 32 Startpositionen ab i prüfen
+    auto block = [&](size_t i) __attribute__((target("avx2"))) {
+        __m256i a = foldAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i)));
+        __m256i b = foldAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i + m - 1)));
+        std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last))));
+        while (mask) {
+            size_t pos = i + __builtin_ctz(mask);
+            if (equalsFolded(s + pos + 1, folded.data() + 1, middle)) return true;
+            mask &= mask - 1;
         }
+        return false;
+    };
+
+    size_t i = 0;
+    for (; i + 32 <= positions; i += 32) {
+        if (block(i)) return true;
     }
+    return i < positions && block(positions - 32);
+}
 
-    refreshNextId_();
-    return true;
+#endif
+
+// Beste verfügbare Variante einmalig zur Laufzeit wählen
+static FindFn selectFinder() {
+#ifdef MUSICMANAGER_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return containsFoldedAvx2;
+#ifdef __SSE2__
+    return containsFoldedSse2;
+#endif
+#endif
+    return containsFoldedScalar;
 }
 
-bool MusicLibrary::saveToCsv(const std::string& path) const {       //Track in CSV Datei speichern
-    std::ofstream file(path);
-    if (!file.is_open()) return false;
+// Enthält text (beliebige Schreibweise) den Suchbegriff folded (Kleinbuchstaben)?
+static bool containsFolded(std::string_view text, std::string_view folded) {
+    static const FindFn find = selectFinder();
+    return find(text, folded);
+}
 
-    file << "id,title,artist,album,year,genre,durationSec\n";
-    for (const auto& t : tracks_) {
-        file << toCsvRow(t) << "\n";
+// Teilstring-Suche ohne Beachtung der Groß-/Kleinschreibung, ohne Kopien auf dem Heap
+// (kurze Suchbegriffe werden auf dem Stack gefaltet)
+bool icontains(std::string_view text, std::string_view search) {
+    char buf[64];
+    std::string big;
+    char* folded = buf;
+    if (search.size() > sizeof(buf)) {
+        big.resize(search.size());
+        folded = &big[0];
     }
+    for (size_t i = 0; i < search.size(); ++i) folded[i] = foldAscii(search[i]);
+    return containsFolded(text, std::string_view(folded, search.size()));
+}
 
-    return true;
+
+
+// Suchbegriff als Jahr: nur wenn er genau so geschrieben ist wie std::to_string(year)
+// (wie bisher der Vergleich std::to_string(t.year) == query)
+static std::optional<int> yearQuery(std::string_view query) {
+    int year = 0;
+    auto res = std::from_chars(query.data(), query.data() + query.size(), year);
+    if (res.ec != std::errc() || res.ptr != query.data() + query.size()) return std::nullopt;
+    if (std::to_string(year) != query) return std::nullopt;
+    return year;
 }
-    
-int MusicLibrary::addTrack(const MusicTrack& t) {                   //neuen Track hinzufügen
-    MusicTrack copy = t;
-    copy.id = nextId_++;
-    copy.title = sanitize(copy.title);
-    copy.artist = sanitize(copy.artist);
-    copy.album = sanitize(copy.album);
-    copy.genre = sanitize(copy.genre);
 
-    tracks_.push_back(copy);
-    return copy.id;
+
+
+// Prüft, ob ein Track (MusicTrack oder MusicTrackView) zur Suche passt.
+// folded: Suchbegriff in Kleinbuchstaben, year: Suchbegriff als Jahr (yearQuery)
+template<typename Track>
+static bool matchesQuery(const Track& t, std::string_view folded, std::optional<int> year, Field by) {
+    switch (by) {
+    case Field::Any:
+        return containsFolded(t.title, folded) ||
+            containsFolded(t.artist, folded) ||
+            containsFolded(t.album, folded) ||
+            containsFolded(t.genre, folded) ||
+            (year && t.year == *year);
+    case Field::Title:  return containsFolded(t.title, folded);
+    case Field::Artist: return containsFolded(t.artist, folded);
+    case Field::Album:  return containsFolded(t.album, folded);
+    case Field::Genre:  return containsFolded(t.genre, folded);
+    case Field::Year:   return year && t.year == *year;
+    }
+    return false;
 }
 
-bool MusicLibrary::updateTrack(int id, const MusicTrack& t) {       //Track aktualisieren
-    for (auto& track : tracks_) {
-        if (track.id == id) {
-            track.title = sanitize(t.title);
-            track.artist = sanitize(t.artist);
-            track.album = sanitize(t.album);
-            track.year = t.year;
-            track.genre = sanitize(t.genre);
-            track.durationSec = t.durationSec;
-            return true;
+
+
+// Für jeden Wörterbucheintrag vorab prüfen, ob er die Suche enthält (Index = Code).
+// folded: Suchbegriff bereits in Kleinbuchstaben
+static std::vector<char> dictionaryMatches(const StringDictionary& dict, std::string_view folded) {
+    std::vector<char> hit(dict.size());
+
+    // Mit Trigramm-Index nur die Kandidaten prüfen
+    std::vector<std::uint32_t> candidates;
+    if (dict.trigramIndexed() && dict.trigrams().candidates(folded, candidates)) {
+        for (std::uint32_t code : candidates) hit[code] = containsFolded(dict.folded(code), folded);
+        return hit;
+    }
+
+    for (std::uint32_t code = 0; code < dict.size(); ++code) {
+        hit[code] = containsFolded(dict.folded(code), folded);
+    }
+    return hit;
+}
+
+
+
+// Fehler für eine Zeile anlegen
+static CsvRowError rowError(CsvError code, int column, size_t offset) {
+    CsvRowError err;
+    err.code = code;
+    err.column = column;
+    err.offset = offset;
+    return err;
+}
+
+
+
+// CSV-Zeile in genau 7 getrimmte Felder aufteilen (Ausschnitte der Zeile, keine Kopien).
+// Ein leeres Feld nach einem abschließenden Komma zählt nicht mit (wie bisher bei getline).
+static CsvRowError splitCsvRow(std::string_view line, std::string_view (&cols)[7]) {
+    size_t count = 0;
+    size_t start = 0;
+
+    while (true) {
+        size_t comma = line.find(',', start);
+        if (comma == std::string_view::npos) {
+            std::string_view last = line.substr(start);
+            if (!last.empty()) {
+                if (count == 7) return rowError(CsvError::FieldCount, 7, start);
+                cols[count++] = trimView(last);
+            }
+            break;
         }
+        if (count == 7) return rowError(CsvError::FieldCount, 7, start);
+        cols[count++] = trimView(line.substr(start, comma - start));
+        start = comma + 1;
     }
-    return false;
+
+    if (count != 7) return rowError(CsvError::FieldCount, static_cast<int>(count), line.size());
+    return CsvRowError{};
 }
-    
-bool MusicLibrary::deleteTrack(int id) {                            //Track löschen
-    for (auto it = tracks_.begin(); it != tracks_.end(); ++it) {
-        if (it->id == id) {
-            tracks_.erase(it);
-            return true;
+
+
+
+// Ganzzahl ohne Exceptions einlesen, verhält sich wie std::stoi:
+// optionales Vorzeichen, mindestens eine Ziffer, Rest des Feldes wird ignoriert.
+// Liefert den Fehlercode, errPos zeigt auf die Stelle des Fehlers.
+static CsvError parseIntField(std::string_view s, int& out, const char*& errPos) {
+    const char* first = s.data();
+    const char* last = s.data() + s.size();
+    errPos = first;
+
+    if (first != last && *first == '+') {
+        ++first;
+        if (first == last || *first == '-') {
+            errPos = first;
+            return CsvError::InvalidNumber;
         }
     }
-    return false;
+
+    auto res = std::from_chars(first, last, out);
+    if (res.ec == std::errc::invalid_argument) {
+        errPos = first;
+        return CsvError::InvalidNumber;
+    }
+    if (res.ec == std::errc::result_out_of_range) return CsvError::OutOfRange;
+    return CsvError::None;
 }
 
-std::optional<MusicTrack> MusicLibrary::findById(int id) const {    //Track suchen nach ID
-    for (const auto& track : tracks_) {
-        if (track.id == id) return track;
+
+
+// Aus 7 getrimmten Feldern einen MusicTrack füllen; out bleibt bei Fehlern unverändert.
+// Fehlerpositionen werden relativ zu rowStart angegeben.
+template<typename Track>
+static CsvRowError parseCsvFields(const std::string_view (&cols)[7], const char* rowStart, Track& out) {
+    // Erst alle Zahlen prüfen
+    static const int numeric[] = { 0, 4, 6 };
+    int values[3] = { 0, 0, 0 };
+    for (int k = 0; k < 3; ++k) {
+        const char* errPos = nullptr;
+        CsvError code = parseIntField(cols[numeric[k]], values[k], errPos);
+        if (code != CsvError::None) {
+            return rowError(code, numeric[k], static_cast<size_t>(errPos - rowStart));
+        }
     }
-    return std::nullopt;
+
+    // Erst hier wird (bei MusicTrack) Speicher für die Strings angelegt,
+    // MusicTrackView zeigt nur auf die Felder der Zeile
+    out.id = values[0];
+    out.title = cols[1];
+    out.artist = cols[2];
+    out.album = cols[3];
+    out.year = values[1];
+    out.genre = cols[5];
+    out.durationSec = values[2];
+    return CsvRowError{};
 }
 
+// Eine einzelne CSV-Zeile in einen MusicTrack umwandeln
+static CsvRowError parseCsvRow(std::string_view row, MusicTrack& out) {
+    std::string_view cols[7];
+    CsvRowError err = splitCsvRow(row, cols);
+    if (err.code != CsvError::None) return err;
+    return parseCsvFields(cols, row.data(), out);
+}
 
 
 
-std::vector<MusicTrack> MusicLibrary::search(const std::string& query, Field by) const {    //Track suchen nach string
-    std::vector<MusicTrack> results;
+//------------------------------------- CSV-Scanner ----------------------------------------------
+// Sucht ',' und '\n' blockweise (32 Byte pro Schritt) statt Zeichen für Zeichen.
+// '\r' und Leerzeichen entfernt trimView, Anführungszeichen sind im Format nicht
+// vorgesehen (toCsvRow schreibt keine) und bleiben normaler Feldinhalt.
 
-    for (const auto& t : tracks_) {
-        bool match = false;
+using ScanFn = void (*)(const char* data, size_t size, std::vector<std::uint32_t>& out);
 
-        switch (by) {
-        case Field::Any:
-            match = icontains(t.title, query) ||
-                icontains(t.artist, query) ||
-                icontains(t.album, query) ||
-                icontains(t.genre, query) ||
-                (std::to_string(t.year) == query);
-            break;
-        case Field::Title:  match = icontains(t.title, query); break;
-        case Field::Artist: match = icontains(t.artist, query); break;
-        case Field::Album:  match = icontains(t.album, query); break;
-        case Field::Genre:  match = icontains(t.genre, query); break;
-        case Field::Year:   match = (std::to_string(t.year) == query); break;
+// Skalare Variante, auch für die Reste am Blockende
+static void scanDelimitersScalar(const char* data, size_t size, std::vector<std::uint32_t>& out) {
+    for (size_t i = 0; i < size; ++i) {
+        if (data[i] == ',' || data[i] == '\n') out.push_back(static_cast<std::uint32_t>(i));
+    }
+}
+
+#ifdef MUSICMANAGER_X86_SIMD
+
+// Alle gesetzten Bits der Maske als Positionen ab base anhängen
+static inline void appendMask(std::uint32_t mask, size_t base, std::vector<std::uint32_t>& out) {
+    while (mask) {
+        out.push_back(static_cast<std::uint32_t>(base + __builtin_ctz(mask)));
+        mask &= mask - 1;
+    }
+}
+
+#ifdef __SSE2__
+static void scanDelimitersSse2(const char* data, size_t size, std::vector<std::uint32_t>& out) {
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 16));
+        std::uint32_t mLo = static_cast<std::uint32_t>(_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(lo, comma), _mm_cmpeq_epi8(lo, newline))));
+        std::uint32_t mHi = static_cast<std::uint32_t>(_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(hi, comma), _mm_cmpeq_epi8(hi, newline))));
+        appendMask(mLo | (mHi << 16), i, out);
+    }
+
+    size_t before = out.size();
+    scanDelimitersScalar(data + i, size - i, out);
+    for (size_t k = before; k < out.size(); ++k) out[k] += static_cast<std::uint32_t>(i);
+}
+#endif
+
+__attribute__((target("avx2")))
+static void scanDelimitersAvx2(const char* data, size_t size, std::vector<std::uint32_t>& out) {
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i newline = _mm256_set1_epi8('\n');
+
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, comma), _mm256_cmpeq_epi8(v, newline))));
+        appendMask(mask, i, out);
+    }
+
+    size_t before = out.size();
+    scanDelimitersScalar(data + i, size - i, out);
+    for (size_t k = before; k < out.size(); ++k) out[k] += static_cast<std::uint32_t>(i);
+}
+
+#endif
+
+// Beste verfügbare Variante einmalig zur Laufzeit wählen
+static ScanFn selectScanner() {
+#ifdef MUSICMANAGER_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return scanDelimitersAvx2;
+#ifdef __SSE2__
+    return scanDelimitersSse2;
+#endif
+#endif
+    return scanDelimitersScalar;
+}
+
+// Positionen (relativ zu data) aller ',' und '\n' in [data, data + size) an out anhängen
+static void scanDelimiters(const char* data, size_t size, std::vector<std::uint32_t>& out) {
+    static const ScanFn scan = selectScanner();
+    scan(data, size, out);
+}
+
+
+
+// Größe der Blöcke, die der Scanner auf einmal verarbeitet
+static constexpr size_t kScanBlockBytes = 1 << 20;
+
+// Zeiger hinter das nächste '\n' ab p (oder end)
+static const char* nextLine(const char* p, const char* end) {
+    const void* nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return nl ? static_cast<const char*>(nl) + 1 : end;
+}
+
+
+
+// Alle Zeilen in [p, end) parsen und gültige Tracks an out anhängen, verworfene
+// Zeilen landen in rejected (Zeilennummern relativ zu p, erste Zeile = 0).
+// Die Daten werden in Blöcken (an Zeilengrenzen) gescannt, danach werden
+// nur noch die gefundenen Trennzeichen-Positionen abgelaufen.
+// out: std::vector<MusicTrackView> oder TrackColumns (reserve + push_back), die Sichten
+// zeigen in [p, end) und müssen vor dessen Freigabe übernommen sein.
+// Rückgabe: Anzahl der Zeilen im Bereich.
+template<typename Tracks>
+static size_t parseCsvLines(const char* p, const char* end, Tracks& out,
+    std::vector<CsvRejection>& rejected) {
+    // Zeilen zählen, damit out nur einmal Speicher anfordert
+    size_t lines = 0;
+    for (const char* q = p; q < end; q = nextLine(q, end)) {
+        ++lines;
+    }
+    out.reserve(out.size() + lines);
+
+    std::vector<std::uint32_t> delims;
+    delims.reserve(kScanBlockBytes / 8);
+    size_t lineNo = 0;
+
+    while (p < end) {
+        const char* blockEnd = end - p > static_cast<std::ptrdiff_t>(kScanBlockBytes)
+            ? nextLine(p + kScanBlockBytes - 1, end) : end;
+        size_t blockSize = static_cast<size_t>(blockEnd - p);
+        if (blockSize > UINT32_MAX) {
+            // Zeile über 4 GiB kann kein gültiger Datensatz sein
+            CsvRejection r;
+            r.line = lineNo++;
+            r.error = rowError(CsvError::FieldCount, 0, 0);
+            rejected.push_back(r);
+            p = blockEnd;
+            continue;
+        }
+
+        delims.clear();
+        scanDelimiters(p, blockSize, delims);
+
+        std::string_view cols[7];
+        size_t count = 0;
+        size_t rowStart = 0;
+        size_t fieldStart = 0;
+        size_t surplusAt = 0;           // Beginn des ersten überzähligen Feldes, 0 = keins
+
+        // Zeile abschließen: letztes Feld nur mitzählen, wenn es nicht leer ist (wie bisher)
+        auto finishRow = [&](size_t fieldEnd) {
+            std::string_view last = trimView(std::string_view(p + fieldStart, fieldEnd - fieldStart));
+            if (!last.empty()) {
+                if (count == 7 && !surplusAt) surplusAt = fieldStart;
+                else if (count < 7) cols[count++] = last;
+            }
+
+            // Leerzeilen werden wie bisher still übersprungen
+            if (count > 0 || surplusAt) {
+                CsvRowError err;
+                MusicTrackView track;
+                if (surplusAt) err = rowError(CsvError::FieldCount, 7, surplusAt - rowStart);
+                else if (count != 7) err = rowError(CsvError::FieldCount, static_cast<int>(count), fieldEnd - rowStart);
+                else err = parseCsvFields(cols, p + rowStart, track);
+
+                if (err.code == CsvError::None) {
+                    out.push_back(track);
+                }
+                else {
+                    CsvRejection r;
+                    r.line = lineNo;
+                    r.error = err;
+                    rejected.push_back(r);
+                }
+            }
+
+            ++lineNo;
+            count = 0;
+            surplusAt = 0;
+        };
+
+        for (std::uint32_t pos : delims) {
+            if (p[pos] == ',') {
+                if (count < 7) cols[count++] = trimView(std::string_view(p + fieldStart, pos - fieldStart));
+                else if (!surplusAt) surplusAt = fieldStart;
+                fieldStart = pos + 1;
+            }
+            else {
+                finishRow(pos);
+                fieldStart = pos + 1;
+                rowStart = fieldStart;
+            }
+        }
+
+        // Letzte Zeile ohne abschließendes '\n'
+        if (fieldStart < blockSize || count > 0) {
+            finishRow(blockSize);
         }
 
-        if (match) results.push_back(t);
+        p = blockEnd;
     }
 
-    return results;
+    return lines;
 }
 
+//------------------------------------- CSV schreiben ----------------------------------------------
 
+// Größe der Blöcke, in denen saveToCsv schreibt
+static constexpr size_t kWriteBlockBytes = 1 << 20;
 
-void MusicLibrary::clear() {                                            //Bib leeren
-    tracks_.clear();
-    nextId_ = 1;
+// Ganzzahl ohne Stream/Allokation anhängen
+static void appendInt(std::string& buf, int v) {
+    char tmp[12];
+    auto res = std::to_chars(tmp, tmp + sizeof(tmp), v);
+    buf.append(tmp, static_cast<size_t>(res.ptr - tmp));
 }
 
-std::string MusicLibrary::sanitize(const std::string& s) {
-    std::string result = trim(s);
-    for (auto& ch : result) {
-        if (ch == '\r' || ch == '\n') ch = ' ';
+// Track (MusicTrack oder MusicTrackView) als CSV-Zeile (ohne Zeilenumbruch) an buf
+// anhängen, gleiche Ausgabe wie toCsvRow
+template<typename Track>
+static void appendCsvRow(std::string& buf, const Track& t) {
+    appendInt(buf, t.id);
+    buf.push_back(',');
+    buf.append(t.title);
+    buf.push_back(',');
+    buf.append(t.artist);
+    buf.push_back(',');
+    buf.append(t.album);
+    buf.push_back(',');
+    appendInt(buf, t.year);
+    buf.push_back(',');
+    buf.append(t.genre);
+    buf.push_back(',');
+    appendInt(buf, t.durationSec);
+}
+
+// Gepufferte Daten bis auf die Platte schreiben (fsync bzw. _commit)
+static bool syncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Temporäre Datei vollständig geschrieben -> atomar an den Zielpfad verschieben
+static bool commitTempFile(const std::string& tmpPath, const std::string& path) {
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        std::remove(tmpPath.c_str());
+        return false;
     }
-    return result;
+    return true;
 }
 
-std::string MusicLibrary::toCsvRow(const MusicTrack& t) {                   //Wandelt Trach zu CSV Zeile um
-    std::ostringstream oss;
-    oss << t.id << "," << t.title << "," << t.artist << "," << t.album << ","
-        << t.year << "," << t.genre << "," << t.durationSec;
-    return oss.str();
+
+// Alle lebenden Tracks blockweise formatiert in file schreiben
+static bool writeCsvRows(std::FILE* file, const TrackColumns& tracks) {
+    std::string buf;
+    buf.reserve(kWriteBlockBytes + 4096);
+
+    for (size_t i = 0; i < tracks.slotCount(); ++i) {
+        if (!tracks.live(i)) continue;
+        appendCsvRow(buf, tracks.view(i));
+        buf.push_back('\n');
+        if (buf.size() >= kWriteBlockBytes) {
+            if (std::fwrite(buf.data(), 1, buf.size(), file) != buf.size()) return false;
+            buf.clear();
+        }
+    }
+    return std::fwrite(buf.data(), 1, buf.size(), file) == buf.size();
+}
+
+// Wartet beim Verlassen des Bereichs auf alle gestarteten Threads. Wirft der
+// std::thread-Konstruktor (z.B. keine Threads mehr verfügbar), fliegt die Ausnahme
+// sonst an noch laufenden Threads vorbei und std::terminate beendet das Programm.
+class ThreadJoiner {
+public:
+    explicit ThreadJoiner(std::vector<std::thread>& threads) : threads_(threads) {}
+    ~ThreadJoiner() { join(); }
+    ThreadJoiner(const ThreadJoiner&) = delete;
+    ThreadJoiner& operator=(const ThreadJoiner&) = delete;
+
+    void join() {
+        for (auto& t : threads_) {
+            if (t.joinable()) t.join();
+        }
+    }
+
+private:
+    std::vector<std::thread>& threads_;
+};
+
+// Ab so vielen Tracks lohnt sich paralleles Formatieren beim Speichern
+static constexpr size_t kParallelSaveMinRows = 100 * 1000;
+
+// Zeilen pro Arbeitspaket beim parallelen Speichern
+static constexpr size_t kSaveBatchRows = 64 * 1024;
+
+// Wie writeCsvRows, aber die Formatierung läuft auf mehreren Threads: pro Runde
+// formatiert jeder Thread ein Paket in seinen eigenen Puffer, die Puffer werden in
+// Reihenfolge geschrieben. Während eine Runde geschrieben wird, wird die nächste
+// schon formatiert (zwei Puffersätze), der Speicherbedarf bleibt begrenzt.
+static bool writeCsvRowsParallel(std::FILE* file, const TrackColumns& tracks, unsigned threads) {
+    const size_t roundRows = kSaveBatchRows * threads;
+    std::vector<std::string> buffers[2] = { std::vector<std::string>(threads), std::vector<std::string>(threads) };
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> workers;
+    ThreadJoiner joiner(workers);
+
+    // Runde ab Zeile start in den Puffersatz set formatieren (Threads laufen danach weiter)
+    auto launch = [&](size_t start, int set) {
+        for (unsigned w = 0; w < threads; ++w) {
+            size_t from = std::min(tracks.slotCount(), start + w * kSaveBatchRows);
+            size_t to = std::min(tracks.slotCount(), from + kSaveBatchRows);
+            workers.emplace_back([&, from, to, set, w] {
+                try {
+                    std::string& buf = buffers[set][w];
+                    buf.clear();
+                    for (size_t i = from; i < to; ++i) {
+                        if (!tracks.live(i)) continue;
+                        appendCsvRow(buf, tracks.view(i));
+                        buf.push_back('\n');
+                    }
+                }
+                catch (...) {
+                    errors[w] = std::current_exception();
+                }
+            });
+        }
+    };
+    auto joinAll = [&] {
+        joiner.join();
+        workers.clear();
+        for (auto& e : errors) {
+            if (e) std::rethrow_exception(e);
+        }
+    };
+
+    bool ok = true;
+    int current = 0;
+    launch(0, current);
+    joinAll();
+
+    for (size_t start = 0; start < tracks.slotCount(); start += roundRows) {
+        bool more = start + roundRows < tracks.slotCount();
+        if (more) launch(start + roundRows, 1 - current);
+
+        for (const std::string& buf : buffers[current]) {
+            ok = ok && std::fwrite(buf.data(), 1, buf.size(), file) == buf.size();
+        }
+
+        if (more) joinAll();
+        current = 1 - current;
+    }
+    return ok;
 }
 
-bool MusicLibrary::fromCsvRow(const std::string& row, MusicTrack& out) {        //Wandelt Track von CSV Zeiele um für UI
-    auto cols = splitCsv(row);
-    if (cols.size() != 7) return false;
 
+// Tracks als CSV-Datei schreiben: erst in eine temporäre Datei, damit ein Absturz die
+// alte Datei nicht zerstört, danach fsync und atomares Umbenennen
+static bool writeCsvFile(const std::string& path, const TrackColumns& tracks, unsigned threads) {
+    const std::string tmpPath = path + ".tmp";
+    std::FILE* file = std::fopen(tmpPath.c_str(), "wb");
+    if (!file) return false;
+    std::setvbuf(file, nullptr, _IONBF, 0);         // gepuffert wird in den eigenen Blöcken
+
+    static const char header[] = "id,title,artist,album,year,genre,durationSec\n";
+    bool ok = std::fwrite(header, 1, sizeof(header) - 1, file) == sizeof(header) - 1;
     try {
-        out.id = std::stoi(cols[0]);
-        out.title = cols[1];
-        out.artist = cols[2];
-        out.album = cols[3];
-        out.year = std::stoi(cols[4]);
-        out.genre = cols[5];
-        out.durationSec = std::stoi(cols[6]);
-        return true;
+        ok = ok && (threads <= 1 || tracks.size() < kParallelSaveMinRows
+            ? writeCsvRows(file, tracks)
+            : writeCsvRowsParallel(file, tracks, threads));
     }
     catch (...) {
+        ok = false;                                 // z.B. kein Speicher für die Puffer
+    }
+    ok = syncFile(file) && ok;
+    ok = (std::fclose(file) == 0) && ok;
+
+    if (!ok) {
+        std::remove(tmpPath.c_str());
         return false;
     }
+    return commitTempFile(tmpPath, path);
 }
 
-void MusicLibrary::refreshNextId_() {
-    int maxId = 0;
-    for (const auto& t : tracks_) {
-        if (t.id > maxId) maxId = t.id;
+
+//------------------------------------- Binär-Snapshot ----------------------------------------------
+// Aufbau (little endian, alle Abschnitte auf 8 Byte ausgerichtet), Version 2:
+//   Kopf (96 Byte):  Magic "MMSNAP\0\0", Version, Byte-Order-Marke, Anzahl Tracks,
+//                    Blob-Größe je Texttabelle (title, artist, album, genre), Flags,
+//                    Anzahl Einträge der Wörterbücher artist, album, genre
+//   Zahlenspalten:   id[n], year[n], durationSec[n] als int32
+//   Codespalten:     artist[n], album[n], genre[n] als uint32 (Index ins Wörterbuch)
+//   Texttabellen:    offsets[Einträge + 1] als uint64 für title (n Einträge) und die
+//                    drei Wörterbücher, danach alle Blobs
+// Version 1 (64-Byte-Kopf, ohne Codespalten, jede Textspalte mit n Einträgen) wird
+// weiterhin gelesen.
+
+static const char kSnapshotMagic[8] = { 'M', 'M', 'S', 'N', 'A', 'P', '\0', '\0' };
+static constexpr std::uint32_t kSnapshotVersion = 2;
+static constexpr std::uint32_t kSnapshotByteOrder = 0x01020304;
+static constexpr size_t kSnapshotHeaderBytesV1 = 64;
+static constexpr size_t kSnapshotHeaderBytes = 96;
+static constexpr std::uint64_t kSnapshotIdsSorted = 1;     // ids streng aufsteigend -> binäre Suche möglich
+
+struct SnapshotHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint64_t count;
+    std::uint64_t blobBytes[4];
+    std::uint64_t flags;
+    std::uint64_t dictCount[3];                     // ab Version 2
+    std::uint64_t reserved;
+};
+static_assert(sizeof(SnapshotHeader) == kSnapshotHeaderBytes, "Snapshot-Kopf muss 96 Byte gross sein");
+
+// Byte-Positionen aller Abschnitte innerhalb der Datei
+struct SnapshotLayout {
+    std::uint32_t version{ kSnapshotVersion };
+    std::uint64_t count{ 0 };
+    std::uint64_t ids{ 0 }, years{ 0 }, durations{ 0 };
+    std::uint64_t codes[3]{};                       // nur Version 2
+    std::uint64_t entries[4]{};                     // Einträge je Texttabelle
+    std::uint64_t offsets[4]{};
+    std::uint64_t blobs[4]{};
+    std::uint64_t blobBytes[4]{};
+    std::uint64_t flags{ 0 };
+    std::uint64_t total{ 0 };
+};
+
+static std::uint64_t align8(std::uint64_t n) {
+    return (n + 7) & ~static_cast<std::uint64_t>(7);
+}
+
+// Abschnitte aus dem Kopf berechnen (für Schreiben und Lesen gleich)
+static SnapshotLayout snapshotLayout(const SnapshotHeader& h) {
+    SnapshotLayout l;
+    l.version = h.version;
+    l.count = h.count;
+    l.flags = h.flags;
+    l.ids = h.version == 1 ? kSnapshotHeaderBytesV1 : kSnapshotHeaderBytes;
+    l.years = l.ids + align8(h.count * 4);
+    l.durations = l.years + align8(h.count * 4);
+    std::uint64_t pos = l.durations + align8(h.count * 4);
+    l.entries[0] = h.count;
+    for (int c = 0; c < 3; ++c) {
+        if (h.version == 1) {
+            l.entries[c + 1] = h.count;
+            continue;
+        }
+        l.codes[c] = pos;
+        pos += align8(h.count * 4);
+        l.entries[c + 1] = h.dictCount[c];
+    }
+    for (int c = 0; c < 4; ++c) {
+        l.offsets[c] = pos;
+        pos += (l.entries[c] + 1) * 8;
+    }
+    for (int c = 0; c < 4; ++c) {
+        l.blobs[c] = pos;
+        l.blobBytes[c] = h.blobBytes[c];
+        pos += align8(h.blobBytes[c]);
+    }
+    l.total = pos;
+    return l;
+}
+
+template<typename T>
+static T readRaw(const char* p) {
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    return v;
+}
+
+// Eintrag i einer Offset-Tabelle, base = Anfang des zugehörigen Blobs
+static std::string_view packedAt(const char* base, const char* offsets, size_t i) {
+    std::uint64_t from = readRaw<std::uint64_t>(offsets + i * 8);
+    std::uint64_t to = readRaw<std::uint64_t>(offsets + (i + 1) * 8);
+    return std::string_view(base + from, static_cast<size_t>(to - from));
+}
+
+// Kopf und Abschnittsgrößen prüfen (ohne die Daten selbst anzufassen)
+static bool readSnapshotLayout(const char* data, size_t size, SnapshotLayout& layout) {
+    if (size < kSnapshotHeaderBytesV1) return false;
+
+    SnapshotHeader h{};
+    std::memcpy(&h, data, kSnapshotHeaderBytesV1);
+    if (std::memcmp(h.magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0) return false;
+    if (h.byteOrder != kSnapshotByteOrder) return false;
+    if (h.version == kSnapshotVersion) {
+        if (size < kSnapshotHeaderBytes) return false;
+        h = readRaw<SnapshotHeader>(data);
+    }
+    else if (h.version != 1) {
+        return false;
+    }
+
+    // Schutz vor Überlauf bei unsinnigen Werten: jeder Track braucht mind. 32 Byte,
+    // jeder Wörterbuch-Eintrag 8 Byte
+    if (h.count > size / 32) return false;
+    for (std::uint64_t d : h.dictCount) {
+        if (d > size / 8) return false;
+    }
+    for (std::uint64_t b : h.blobBytes) {
+        if (b > size) return false;
+    }
+
+    layout = snapshotLayout(h);
+    return layout.total == size;
+}
+
+// Kopf prüfen, danach jede Offset-Tabelle (monoton, innerhalb des Blobs) und alle Codes.
+// Ist alles in Ordnung, kann ohne weitere Prüfung auf die Daten zugegriffen werden.
+static bool validateSnapshot(const char* data, size_t size, SnapshotLayout& layout) {
+    if (!readSnapshotLayout(data, size, layout)) return false;
+
+    for (int c = 0; c < 4; ++c) {
+        const char* offs = data + layout.offsets[c];
+        std::uint64_t prev = readRaw<std::uint64_t>(offs);
+        if (prev != 0) return false;
+        for (std::uint64_t i = 1; i <= layout.entries[c]; ++i) {
+            std::uint64_t cur = readRaw<std::uint64_t>(offs + i * 8);
+            if (cur < prev) return false;
+            prev = cur;
+        }
+        if (prev != layout.blobBytes[c]) return false;
+    }
+    if (layout.version == 1) return true;
+
+    for (int c = 0; c < 3; ++c) {
+        const char* codes = data + layout.codes[c];
+        const std::uint64_t limit = layout.entries[c + 1];
+        for (std::uint64_t i = 0; i < layout.count; ++i) {
+            if (readRaw<std::uint32_t>(codes + i * 4) >= limit) return false;
+        }
+    }
+    return true;
+}
+
+
+//------------------------------------- Journal ----------------------------------------------
+// Datei beginnt mit Magic "MMJRNL01", danach folgen Einträge:
+//   uint32 Länge, uint32 Prüfsumme (FNV-1a), Nutzdaten:
+//   uint8 Art, int32 id, bei Add/Update zusätzlich int32 year, int32 durationSec
+//   und title, artist, album, genre jeweils als uint32 Länge + Bytes.
+// Ein abgeschnittener oder beschädigter letzter Eintrag (Absturz beim Schreiben)
+// beendet das Einlesen, alles davor bleibt gültig.
+
+static const char kJournalMagic[8] = { 'M', 'M', 'J', 'R', 'N', 'L', '0', '1' };
+
+enum JournalRecord : unsigned char { kJournalAdd = 1, kJournalUpdate = 2, kJournalDelete = 3 };
+
+static std::uint32_t fnv1a(const char* data, size_t size) {
+    std::uint32_t h = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+template<typename T>
+static void appendRaw(std::string& buf, T v) {
+    char tmp[sizeof(T)];
+    std::memcpy(tmp, &v, sizeof(T));
+    buf.append(tmp, sizeof(T));
+}
+
+// Eintrag in buf kodieren (buf wird wiederverwendet)
+static void encodeJournalRecord(std::string& buf, unsigned char type, const MusicTrack& t) {
+    buf.assign(8, '\0');                    // Platz für Länge und Prüfsumme
+    buf.push_back(static_cast<char>(type));
+    appendRaw<std::int32_t>(buf, t.id);
+    if (type != kJournalDelete) {
+        appendRaw<std::int32_t>(buf, t.year);
+        appendRaw<std::int32_t>(buf, t.durationSec);
+        for (const std::string* str : { &t.title, &t.artist, &t.album, &t.genre }) {
+            appendRaw<std::uint32_t>(buf, static_cast<std::uint32_t>(str->size()));
+            buf.append(*str);
+        }
+    }
+
+    std::uint32_t len = static_cast<std::uint32_t>(buf.size() - 8);
+    std::uint32_t sum = fnv1a(buf.data() + 8, len);
+    std::memcpy(&buf[0], &len, 4);
+    std::memcpy(&buf[4], &sum, 4);
+}
+
+// Nutzdaten eines Eintrags lesen, false bei inkonsistenten Daten
+static bool decodeJournalRecord(const char* p, size_t len, unsigned char& type, MusicTrack& t) {
+    if (len < 5) return false;
+    type = static_cast<unsigned char>(p[0]);
+    t.id = readRaw<std::int32_t>(p + 1);
+    if (type == kJournalDelete) return len == 5;
+    if (type != kJournalAdd && type != kJournalUpdate) return false;
+
+    size_t pos = 5;
+    if (len < pos + 8) return false;
+    t.year = readRaw<std::int32_t>(p + pos);
+    t.durationSec = readRaw<std::int32_t>(p + pos + 4);
+    pos += 8;
+    for (std::string* str : { &t.title, &t.artist, &t.album, &t.genre }) {
+        if (len < pos + 4) return false;
+        std::uint32_t n = readRaw<std::uint32_t>(p + pos);
+        pos += 4;
+        if (len - pos < n) return false;
+        str->assign(p + pos, n);
+        pos += n;
+    }
+    return pos == len;
+}
+
+
+//--------------------------------- MappedFile ---------------------------------------------------
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(other.data_), size_(other.size_), open_(other.open_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.open_ = false;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = other.data_;
+        size_ = other.size_;
+        open_ = other.open_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.open_ = false;
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string& path) {                   //Datei einblenden
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER len;
+    if (!GetFileSizeEx(file, &len)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    // Leere Datei: gültig, aber nichts einzublenden
+    if (len.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) {
+            CloseHandle(file);
+            return false;
+        }
+        void* p = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);               // View hält das Mapping selbst am Leben
+        if (!p) {
+            CloseHandle(file);
+            return false;
+        }
+        data_ = static_cast<const char*>(p);
+        size_ = static_cast<std::size_t>(len.QuadPart);
+    }
+    CloseHandle(file);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+
+    // Leere Datei: gültig, aber nichts einzublenden
+    if (st.st_size > 0) {
+        void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(p);
+        size_ = static_cast<std::size_t>(st.st_size);
+    }
+    ::close(fd);                            // Mapping bleibt auch ohne Deskriptor bestehen
+#endif
+
+    open_ = true;
+    return true;
+}
+
+void MappedFile::close() {                                          //Datei ausblenden
+    if (data_) {
+#ifdef _WIN32
+        UnmapViewOfFile(data_);
+#else
+        munmap(const_cast<char*>(data_), size_);
+#endif
+    }
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+}
+
+
+//--------------------------------- JournalFile ---------------------------------------------------
+
+JournalFile::JournalFile(JournalFile&& other) noexcept
+    : file_(other.file_), path_(std::move(other.path_)) {
+    other.file_ = nullptr;
+}
+
+JournalFile& JournalFile::operator=(JournalFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        file_ = other.file_;
+        path_ = std::move(other.path_);
+        other.file_ = nullptr;
+    }
+    return *this;
+}
+
+bool JournalFile::open(const std::string& path) {                   //Journal zum Anhängen öffnen
+    close();
+    file_ = std::fopen(path.c_str(), "ab");
+    if (!file_) return false;
+    path_ = path;
+    return true;
+}
+
+void JournalFile::close() {
+    if (file_) {
+        sync();
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+bool JournalFile::append(const char* data, std::size_t size) {
+    if (!file_) return false;
+    return std::fwrite(data, 1, size, file_) == size;
+}
+
+bool JournalFile::sync() {                                          //bis auf die Platte schreiben
+    return file_ && syncFile(file_);
+}
+
+bool JournalFile::reset(const char* data, std::size_t size) {       //Inhalt verwerfen, neu beginnen
+    if (!file_) return false;
+    std::FILE* fresh = std::freopen(path_.c_str(), "wb", file_);
+    file_ = fresh;
+    if (!file_) return false;
+    return append(data, size) && sync();
+}
+
+bool JournalFile::replace(const char* data, std::size_t size) {     //Inhalt atomar ersetzen
+    if (!file_) return false;
+    const std::string tmpPath = path_ + ".tmp";
+    std::FILE* tmp = std::fopen(tmpPath.c_str(), "wb");
+    if (!tmp) return false;
+    bool ok = std::fwrite(data, 1, size, tmp) == size;
+    ok = syncFile(tmp) && ok;
+    ok = (std::fclose(tmp) == 0) && ok;
+
+    // Vor dem Umbenennen schließen (unter Windows sonst gesperrt), danach wieder anhängen
+    ok = sync() && ok;
+    std::fclose(file_);
+    ok = ok && commitTempFile(tmpPath, path_);
+    if (!ok) std::remove(tmpPath.c_str());
+    file_ = std::fopen(path_.c_str(), "ab");
+    return ok && file_ != nullptr;
+}
+
+
+//------------------------------------- Abfragen ----------------------------------------------
+
+Query Query::contains(Field by, std::string text) {
+    Query q;
+    q.kind_ = Kind::Contains;
+    q.field_ = by;
+    q.text_ = std::move(text);
+    return q;
+}
+
+Query Query::equals(Field by, std::string text) {
+    Query q = contains(by, std::move(text));
+    q.kind_ = Kind::Equals;
+    return q;
+}
+
+Query Query::range(RangeField by, int lo, int hi) {
+    Query q;
+    q.kind_ = Kind::Range;
+    q.rangeField_ = by;
+    q.lo_ = lo;
+    q.hi_ = hi;
+    return q;
+}
+
+Query Query::allOf(std::vector<Query> parts) {                      //leer: trifft immer zu
+    Query q;
+    q.kind_ = Kind::And;
+    q.parts_ = std::move(parts);
+    return q;
+}
+
+Query Query::anyOf(std::vector<Query> parts) {                      //leer: trifft nie zu
+    Query q;
+    q.kind_ = Kind::Or;
+    q.parts_ = std::move(parts);
+    return q;
+}
+
+Query Query::negate(Query part) {
+    Query q;
+    q.kind_ = Kind::Not;
+    q.parts_.push_back(std::move(part));
+    return q;
+}
+
+// Gleichartige Verknüpfungen flach halten, damit der Planer alle Teile gemeinsam ordnet
+static void appendFlat(std::vector<Query>& parts, Query q, Query::Kind kind) {
+    if (q.kind() == kind) parts.insert(parts.end(), q.parts().begin(), q.parts().end());
+    else parts.push_back(std::move(q));
+}
+
+Query operator&&(Query a, Query b) {
+    std::vector<Query> parts;
+    appendFlat(parts, std::move(a), Query::Kind::And);
+    appendFlat(parts, std::move(b), Query::Kind::And);
+    return Query::allOf(std::move(parts));
+}
+
+Query operator||(Query a, Query b) {
+    std::vector<Query> parts;
+    appendFlat(parts, std::move(a), Query::Kind::Or);
+    appendFlat(parts, std::move(b), Query::Kind::Or);
+    return Query::anyOf(std::move(parts));
+}
+
+Query operator!(Query q) {
+    return Query::negate(std::move(q));
+}
+
+
+// Rekursiver Abstieg über die Syntax aus Query::parse:
+//   oder  := und (("OR" | "||") und)*
+//   und   := nicht (("AND" | "&&") nicht)*
+//   nicht := ("NOT" | "!") nicht | "(" oder ")" | feld op wert | wert
+
+class QueryParser {
+public:
+    explicit QueryParser(std::string_view text) : s_(text) {}
+
+    std::optional<Query> run(std::string* error) {
+        std::optional<Query> q = parseOr();
+        skipSpace();
+        if (q && pos_ < s_.size()) q = fail("unerwartetes Zeichen an Position " + std::to_string(pos_ + 1));
+        if (!q && error) *error = error_;
+        return q;
+    }
+
+private:
+    std::string_view s_;
+    size_t pos_{ 0 };
+    std::string error_;
+
+    std::optional<Query> fail(std::string message) {
+        if (error_.empty()) error_ = std::move(message);
+        return std::nullopt;
+    }
+
+    static bool wordChar(char ch) {
+        return ch != ' ' && ch != '\t' && !std::strchr("()\"<>=!:&|", ch);
+    }
+
+    void skipSpace() {
+        while (pos_ < s_.size() && (s_[pos_] == ' ' || s_[pos_] == '\t')) ++pos_;
+    }
+
+    // Schlüsselwort (ganzes Wort, ohne Groß/Klein) oder Symbol verbrauchen
+    bool keyword(std::string_view word, std::string_view symbol) {
+        skipSpace();
+        std::string_view rest = s_.substr(pos_);
+        if (!symbol.empty() && rest.substr(0, symbol.size()) == symbol &&
+            !(symbol == "!" && rest.substr(0, 2) == "!=")) {
+            pos_ += symbol.size();
+            return true;
+        }
+        if (rest.size() < word.size() || foldCase(rest.substr(0, word.size())) != foldCase(word)) return false;
+        if (rest.size() > word.size() && wordChar(rest[word.size()])) return false;
+        pos_ += word.size();
+        return true;
+    }
+
+    bool isKeyword(std::string_view word) const {
+        const std::string w = foldCase(word);
+        return w == "and" || w == "or" || w == "not";
+    }
+
+    // Wort oder Text in "..."
+    bool readValue(std::string& out, bool& quoted) {
+        skipSpace();
+        quoted = pos_ < s_.size() && s_[pos_] == '"';
+        if (quoted) {
+            size_t end = s_.find('"', pos_ + 1);
+            if (end == std::string_view::npos) return false;
+            out.assign(s_.substr(pos_ + 1, end - pos_ - 1));
+            pos_ = end + 1;
+            return true;
+        }
+        size_t start = pos_;
+        while (pos_ < s_.size() && wordChar(s_[pos_])) ++pos_;
+        out.assign(s_.substr(start, pos_ - start));
+        return !out.empty();
+    }
+
+    // Vergleichsoperator nach einem Feldnamen, leer wenn keiner folgt
+    std::string_view readOperator() {
+        skipSpace();
+        for (std::string_view op : { "<=", ">=", "!=", "==", ":", "=", "<", ">" }) {
+            if (s_.substr(pos_, op.size()) == op) {
+                pos_ += op.size();
+                return op;
+            }
+        }
+        return {};
+    }
+
+    std::optional<Query> parseOr() {
+        std::optional<Query> first = parseAnd();
+        if (!first) return first;
+        std::vector<Query> parts{ std::move(*first) };
+        while (keyword("or", "||")) {
+            std::optional<Query> next = parseAnd();
+            if (!next) return next;
+            parts.push_back(std::move(*next));
+        }
+        if (parts.size() == 1) return std::move(parts[0]);
+        return Query::anyOf(std::move(parts));
+    }
+
+    std::optional<Query> parseAnd() {
+        std::optional<Query> first = parseNot();
+        if (!first) return first;
+        std::vector<Query> parts{ std::move(*first) };
+        while (keyword("and", "&&")) {
+            std::optional<Query> next = parseNot();
+            if (!next) return next;
+            parts.push_back(std::move(*next));
+        }
+        if (parts.size() == 1) return std::move(parts[0]);
+        return Query::allOf(std::move(parts));
+    }
+
+    std::optional<Query> parseNot() {
+        if (keyword("not", "!")) {
+            std::optional<Query> part = parseNot();
+            if (!part) return part;
+            return Query::negate(std::move(*part));
+        }
+        skipSpace();
+        if (pos_ < s_.size() && s_[pos_] == '(') {
+            ++pos_;
+            std::optional<Query> inner = parseOr();
+            if (!inner) return inner;
+            skipSpace();
+            if (pos_ >= s_.size() || s_[pos_] != ')') return fail("')' erwartet");
+            ++pos_;
+            return inner;
+        }
+        return parseTerm();
+    }
+
+    std::optional<Query> parseTerm() {
+        std::string word;
+        bool quoted = false;
+        if (!readValue(word, quoted)) return fail(quoted ? "'\"' nicht geschlossen" : "Suchbegriff erwartet");
+        if (!quoted && isKeyword(word)) return fail("Suchbegriff vor '" + word + "' erwartet");
+
+        const std::string_view op = quoted ? std::string_view() : readOperator();
+        if (op.empty()) return Query::contains(Field::Any, std::move(word));    // nur Text: alle Felder
+
+        std::string value;
+        bool valueQuoted = false;
+        if (!readValue(value, valueQuoted)) return fail("Wert nach '" + word + std::string(op) + "' erwartet");
+
+        const std::string name = foldCase(word);
+        if (name == "year" || name == "jahr") return numberTerm(RangeField::Year, op, value);
+        if (name == "duration" || name == "dauer") return numberTerm(RangeField::Duration, op, value);
+
+        Field by;
+        if (name == "any" || name == "alle") by = Field::Any;
+        else if (name == "title" || name == "titel") by = Field::Title;
+        else if (name == "artist" || name == "interpret") by = Field::Artist;
+        else if (name == "album") by = Field::Album;
+        else if (name == "genre") by = Field::Genre;
+        else return fail("unbekanntes Feld '" + word + "'");
+
+        if (op == ":") return Query::contains(by, std::move(value));
+        if (op == "=" || op == "==") return Query::equals(by, std::move(value));
+        if (op == "!=") return Query::negate(Query::equals(by, std::move(value)));
+        return fail("'" + std::string(op) + "' nur bei year und duration");
+    }
+
+    std::optional<Query> numberTerm(RangeField by, std::string_view op, const std::string& value) {
+        int v = 0;
+        auto res = std::from_chars(value.data(), value.data() + value.size(), v);
+        if (res.ec != std::errc() || res.ptr != value.data() + value.size()) return fail("Zahl erwartet statt '" + value + "'");
+
+        // < INT_MIN bzw. > INT_MAX ergibt einen leeren Bereich (lo > hi)
+        if (op == "<") return v == INT_MIN ? Query::range(by, 1, 0) : Query::range(by, INT_MIN, v - 1);
+        if (op == "<=") return Query::range(by, INT_MIN, v);
+        if (op == ">") return v == INT_MAX ? Query::range(by, 1, 0) : Query::range(by, v + 1, INT_MAX);
+        if (op == ">=") return Query::range(by, v, INT_MAX);
+        if (op == "!=") return Query::negate(Query::range(by, v, v));
+        return Query::range(by, v, v);                                   // ":", "=", "=="
+    }
+};
+
+std::optional<Query> Query::parse(std::string_view text, std::string* error) {
+    return QueryParser(text).run(error);
+}
+
+
+// Bereich [lo, hi] in der sortierten Slot-Ordnung einer Zahlenspalte
+using SlotRange = std::pair<std::vector<std::uint32_t>::const_iterator, std::vector<std::uint32_t>::const_iterator>;
+
+static SlotRange rangeInOrder(const TrackColumns& cols, RangeField by, int lo, int hi) {
+    const bool byYear = by == RangeField::Year;
+    const std::vector<int>& column = byYear ? cols.years() : cols.durations();
+    const std::vector<std::uint32_t>& order = byYear ? cols.yearOrder() : cols.durationOrder();
+    if (lo > hi) return { order.end(), order.end() };
+
+    auto first = std::lower_bound(order.begin(), order.end(), lo,
+        [&](std::uint32_t slot, int v) { return column[slot] < v; });
+    auto last = std::upper_bound(first, order.end(), hi,
+        [&](int v, std::uint32_t slot) { return v < column[slot]; });
+    return { first, last };
+}
+
+// Slots mit genau diesem gefalteten Titel in der Titel-Ordnung
+static SlotRange titleInOrder(const TrackColumns& cols, std::string_view folded) {
+    const std::vector<std::uint32_t>& order = cols.titleOrder();
+    auto first = std::lower_bound(order.begin(), order.end(), folded,
+        [&](std::uint32_t slot, std::string_view key) { return cols.foldedTitle(slot) < key; });
+    auto last = std::upper_bound(first, order.end(), folded,
+        [&](std::string_view key, std::uint32_t slot) { return key < cols.foldedTitle(slot); });
+    return { first, last };
+}
+
+
+// Ausführbarer Knoten einer Abfrage. Der Planer rechnet für jeden Knoten den erwarteten
+// Anteil passender Zeilen (pass) und die Kosten einer Prüfung (cost, 1 = ein Zahlen-
+// vergleich) aus und sortiert damit die Teile von AND/OR in Prüfreihenfolge.
+
+struct QueryPlan {
+    Query::Kind kind{ Query::Kind::And };
+    Field field{ Field::Any };
+    RangeField rangeField{ RangeField::Year };
+    int lo{ 0 };
+    int hi{ 0 };
+    std::string folded;                             // Text in Kleinbuchstaben
+    std::optional<int> year;                        // Field::Any: Text als Jahr
+    std::vector<char> artistHit, albumHit, genreHit;
+    double pass{ 1.0 };
+    double cost{ 0.0 };
+    bool indexed{ false };                          // Kandidaten aus einem Index möglich
+    std::vector<QueryPlan> parts;
+};
+
+// Schätzwert für Teilstring-Suchen im Titel ohne Trigramm-Index
+static constexpr double kUnknownPass = 0.1;
+
+// Anteil der lebenden Tracks, deren Code in hit markiert ist
+static double dictionaryPass(const std::vector<char>& hit, const std::vector<std::uint32_t>& uses, double live) {
+    double n = 0;
+    for (size_t code = 0; code < hit.size() && code < uses.size(); ++code) {
+        if (hit[code]) n += uses[code];
+    }
+    return std::min(1.0, n / live);
+}
+
+static std::vector<char> dictionaryEquals(const StringDictionary& dict, std::string_view folded) {
+    std::vector<char> hit(dict.size());
+    for (std::uint32_t code = 0; code < dict.size(); ++code) hit[code] = dict.folded(code) == folded;
+    return hit;
+}
+
+static QueryPlan planQuery(const Query& q, const TrackColumns& cols) {
+    QueryPlan p;
+    p.kind = q.kind();
+    const double live = std::max<double>(1.0, static_cast<double>(cols.size()));
+    const double slots = std::max<double>(1.0, static_cast<double>(cols.slotCount()));
+
+    switch (q.kind()) {
+    case Query::Kind::Range: {
+        p.rangeField = q.rangeField();
+        p.lo = q.lo();
+        p.hi = q.hi();
+        SlotRange r = rangeInOrder(cols, p.rangeField, p.lo, p.hi);
+        p.pass = static_cast<double>(r.second - r.first) / slots;
+        p.cost = 1.0;
+        p.indexed = true;
+        return p;
+    }
+
+    case Query::Kind::Contains:
+    case Query::Kind::Equals: {
+        // Jahr als Text wird zum Bereich (wie search: nur die kanonische Schreibweise)
+        if (q.field() == Field::Year) {
+            std::optional<int> year = yearQuery(q.text());
+            return planQuery(year ? Query::range(RangeField::Year, *year, *year) : Query::range(RangeField::Year, 1, 0), cols);
+        }
+        const bool exact = q.kind() == Query::Kind::Equals;
+        p.field = q.field();
+        p.folded = foldCase(q.text());
+        auto matches = [&](const StringDictionary& dict) {
+            return exact ? dictionaryEquals(dict, p.folded) : dictionaryMatches(dict, p.folded);
+        };
+
+        // Titel: gleich über die Titel-Ordnung, enthält über den Trigramm-Index (falls an)
+        double titlePass = kUnknownPass;
+        if (p.field == Field::Title || p.field == Field::Any) {
+            std::vector<std::uint32_t> candidates;
+            if (exact) {
+                SlotRange r = titleInOrder(cols, p.folded);
+                titlePass = static_cast<double>(r.second - r.first) / slots;
+                p.indexed = p.field == Field::Title;
+            }
+            else if (p.folded.empty()) {
+                titlePass = 1.0;
+            }
+            else if (cols.trigramIndexed() && cols.titleTrigrams().candidates(p.folded, candidates)) {
+                titlePass = static_cast<double>(candidates.size()) / slots;
+                p.indexed = p.field == Field::Title;
+            }
+        }
+        const double titleCost = exact ? 2.0 : 4.0 + static_cast<double>(p.folded.size()) / 8.0;
+
+        switch (p.field) {
+        case Field::Title:
+            p.pass = titlePass;
+            p.cost = titleCost;
+            break;
+        case Field::Artist:
+            p.artistHit = matches(cols.artistDict());
+            p.pass = dictionaryPass(p.artistHit, cols.artistUses(), live);
+            p.cost = 1.0;
+            break;
+        case Field::Album:
+            p.albumHit = matches(cols.albumDict());
+            p.pass = dictionaryPass(p.albumHit, cols.albumUses(), live);
+            p.cost = 1.0;
+            break;
+        case Field::Genre:
+            p.genreHit = matches(cols.genreDict());
+            p.pass = dictionaryPass(p.genreHit, cols.genreUses(), live);
+            p.cost = 1.0;
+            break;
+        default: {
+            p.artistHit = matches(cols.artistDict());
+            p.albumHit = matches(cols.albumDict());
+            p.genreHit = matches(cols.genreDict());
+            p.year = yearQuery(q.text());
+            double yearPass = 0.0;
+            if (p.year) {
+                SlotRange r = rangeInOrder(cols, RangeField::Year, *p.year, *p.year);
+                yearPass = static_cast<double>(r.second - r.first) / slots;
+            }
+            p.pass = std::min(1.0, dictionaryPass(p.artistHit, cols.artistUses(), live) +
+                dictionaryPass(p.albumHit, cols.albumUses(), live) +
+                dictionaryPass(p.genreHit, cols.genreUses(), live) + titlePass + yearPass);
+            p.cost = 4.0 + titleCost;
+            break;
+        }
+        }
+        return p;
+    }
+
+    case Query::Kind::Not: {
+        p.parts.push_back(planQuery(q.parts()[0], cols));
+        p.pass = 1.0 - p.parts[0].pass;
+        p.cost = p.parts[0].cost;
+        return p;
+    }
+
+    case Query::Kind::And:
+    case Query::Kind::Or: {
+        const bool isAnd = q.kind() == Query::Kind::And;
+        for (const Query& part : q.parts()) p.parts.push_back(planQuery(part, cols));
+
+        // AND: Teile mit kleinem cost / (1 - pass) zuerst (billig und fällt oft durch),
+        // OR: kleines cost / pass zuerst (billig und trifft oft)
+        auto rank = [isAnd](const QueryPlan& x) {
+            const double decisive = isAnd ? 1.0 - x.pass : x.pass;
+            return decisive <= 0.0 ? INFINITY : x.cost / decisive;
+        };
+        std::stable_sort(p.parts.begin(), p.parts.end(),
+            [&](const QueryPlan& a, const QueryPlan& b) { return rank(a) < rank(b); });
+
+        // Erwartete Kosten: ein Teil wird nur geprüft, wenn die vorigen nicht entschieden haben
+        double reach = 1.0;
+        p.indexed = !isAnd && !p.parts.empty();
+        for (const QueryPlan& part : p.parts) {
+            p.cost += reach * part.cost;
+            reach *= isAnd ? part.pass : 1.0 - part.pass;
+            if (isAnd) p.indexed = p.indexed || part.indexed;
+            else p.indexed = p.indexed && part.indexed;
+        }
+        p.pass = isAnd ? reach : 1.0 - reach;
+        return p;
+    }
+    }
+    return p;
+}
+
+static bool planHit(const QueryPlan& p, const TrackColumns& cols, size_t i) {
+    switch (p.kind) {
+    case Query::Kind::And:
+        for (const QueryPlan& part : p.parts) {
+            if (!planHit(part, cols, i)) return false;
+        }
+        return true;
+    case Query::Kind::Or:
+        for (const QueryPlan& part : p.parts) {
+            if (planHit(part, cols, i)) return true;
+        }
+        return false;
+    case Query::Kind::Not:
+        return !planHit(p.parts[0], cols, i);
+    case Query::Kind::Range: {
+        const int v = p.rangeField == RangeField::Year ? cols.years()[i] : cols.durations()[i];
+        return v >= p.lo && v <= p.hi;
+    }
+    default:
+        break;
+    }
+
+    auto titleHit = [&] {
+        return p.kind == Query::Kind::Equals ? cols.foldedTitle(i) == p.folded : containsFolded(cols.foldedTitle(i), p.folded);
+    };
+    switch (p.field) {
+    case Field::Title:  return titleHit();
+    case Field::Artist: return p.artistHit[cols.artistCodes()[i]];
+    case Field::Album:  return p.albumHit[cols.albumCodes()[i]];
+    case Field::Genre:  return p.genreHit[cols.genreCodes()[i]];
+    default:
+        return p.artistHit[cols.artistCodes()[i]] || p.albumHit[cols.albumCodes()[i]] ||
+            p.genreHit[cols.genreCodes()[i]] || titleHit() || (p.year && cols.years()[i] == *p.year);
+    }
+}
+
+// Kandidaten-Slots (aufsteigend, ohne Doppelte) aus den Indizes. Sie enthalten alle
+// Treffer des Knotens, geprüft wird danach trotzdem jede Zeile.
+static void planCandidates(const QueryPlan& p, const TrackColumns& cols, std::vector<std::uint32_t>& out) {
+    out.clear();
+    switch (p.kind) {
+    case Query::Kind::Range: {
+        SlotRange r = rangeInOrder(cols, p.rangeField, p.lo, p.hi);
+        out.assign(r.first, r.second);
+        std::sort(out.begin(), out.end());
+        return;
+    }
+    case Query::Kind::Equals: {
+        SlotRange r = titleInOrder(cols, p.folded);
+        out.assign(r.first, r.second);
+        std::sort(out.begin(), out.end());
+        return;
+    }
+    case Query::Kind::Contains:
+        cols.titleTrigrams().candidates(p.folded, out);
+        return;
+    case Query::Kind::And: {
+        // Der seltenste Teil mit Index liefert die Kandidaten
+        const QueryPlan* best = nullptr;
+        for (const QueryPlan& part : p.parts) {
+            if (part.indexed && (!best || part.pass < best->pass)) best = &part;
+        }
+        if (best) planCandidates(*best, cols, out);
+        return;
+    }
+    case Query::Kind::Or: {
+        std::vector<std::uint32_t> part, merged;
+        for (const QueryPlan& x : p.parts) {
+            planCandidates(x, cols, part);
+            merged.clear();
+            std::set_union(out.begin(), out.end(), part.begin(), part.end(), std::back_inserter(merged));
+            out.swap(merged);
+        }
+        return;
+    }
+    default:
+        return;
+    }
+}
+
+
+
+//--------------------------------- Methoden der MusicLibrary---------------------------------------------------
+
+bool MusicLibrary::loadFromCsv(const std::string& path) {           //Track aus CSV Datei laden
+    return loadMapped_(path, 1);
+}
+
+bool MusicLibrary::loadFromCsvParallel(const std::string& path, unsigned threads) {   //Track aus CSV Datei parallel laden
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return loadMapped_(path, threads);
+}
+
+bool MusicLibrary::loadMapped_(const std::string& path, unsigned threads) {
+    clear();
+    std::lock_guard<std::mutex> lock(editMutex_.m);
+    loadStats_ = LoadStats{};
+    rejected_.clear();
+    auto started = std::chrono::steady_clock::now();
+
+    MappedFile file(path);
+    if (!file.isOpen()) return false;
+
+    const char* end = file.data() + file.size();
+    const char* body = nextLine(file.data(), end);       // Kopfzeile ignorieren
+    size_t bodySize = static_cast<size_t>(end - body);
+
+    // Keine Mini-Blöcke: jeder Thread bekommt mindestens kMinChunkBytes
+    size_t chunks = std::min<size_t>(threads, bodySize / kMinChunkBytes);
+    if (chunks <= 1) {
+        parseCsvLines(body, end, cols_, rejected_);
+        for (auto& r : rejected_) r.line += 2;           // Kopfzeile = Zeile 1
+    }
+    else {
+        // Blockgrenzen jeweils hinter das nächste '\n' verschieben
+        std::vector<const char*> bounds(chunks + 1);
+        bounds[0] = body;
+        bounds[chunks] = end;
+        for (size_t i = 1; i < chunks; ++i) {
+            const char* guess = body + bodySize / chunks * i;
+            bounds[i] = guess <= bounds[i - 1] ? bounds[i - 1] : nextLine(guess - 1, end);
+        }
+
+        std::vector<std::vector<MusicTrackView>> parts(chunks);
+        std::vector<std::vector<CsvRejection>> partRejected(chunks);
+        std::vector<size_t> partLines(chunks);
+        std::vector<std::exception_ptr> errors(chunks);
+        std::vector<std::thread> workers;
+        ThreadJoiner joiner(workers);
+        workers.reserve(chunks);
+        for (size_t i = 0; i < chunks; ++i) {
+            workers.emplace_back([&, i] {
+                try {
+                    partLines[i] = parseCsvLines(bounds[i], bounds[i + 1], parts[i], partRejected[i]);
+                }
+                catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+        joiner.join();
+        for (auto& e : errors) {
+            if (e) std::rethrow_exception(e);
+        }
+
+        // Teilergebnisse in Dateireihenfolge zusammenführen
+        size_t total = 0;
+        for (const auto& part : parts) total += part.size();
+        cols_.reserve(total);
+        for (auto& part : parts) {
+            for (const auto& t : part) cols_.push_back(t);
+            part = std::vector<MusicTrackView>();
+        }
+
+        // Zeilennummern der Blöcke auf die ganze Datei umrechnen
+        size_t firstLine = 2;                           // Kopfzeile = Zeile 1
+        for (size_t i = 0; i < chunks; ++i) {
+            for (auto& r : partRejected[i]) {
+                r.line += firstLine;
+                rejected_.push_back(r);
+            }
+            firstLine += partLines[i];
+        }
+    }
+
+    refreshNextId_();
+
+    loadStats_.bytes = file.size();
+    loadStats_.rows = cols_.size();
+    loadStats_.rejected = rejected_.size();
+    loadStats_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return true;
+}
+
+bool MusicLibrary::saveToCsv(const std::string& path) const {       //Track in CSV Datei speichern
+    return saveCsv_(path, 1);
+}
+
+bool MusicLibrary::saveToCsvParallel(const std::string& path, unsigned threads) const {   //Track parallel formatiert speichern
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return saveCsv_(path, threads);
+}
+
+bool MusicLibrary::saveCsv_(const std::string& path, unsigned threads) const {
+    std::lock_guard<std::mutex> lock(saveMutex_.m);
+    return writeCsvFile(path, cols_, threads);
+}
+
+bool MusicLibrary::saveCopyToCsv(const std::string& path, unsigned threads) const {    //Momentaufnahme speichern
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Kopie erst nach dem Speicher-Lock ziehen: wer später schreibt, hat auch neuere Daten
+    std::lock_guard<std::mutex> saveLock(saveMutex_.m);
+    TrackColumns copy;
+    {
+        std::lock_guard<std::mutex> editLock(editMutex_.m);
+        copy = cols_;
+    }
+    return writeCsvFile(path, copy, threads);
+}
+
+bool MusicLibrary::checkpointCopy(const std::string& csvPath, unsigned threads) {   //Momentaufnahme als neue Basis
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Mit der Kopie festhalten, bis wohin das Journal in ihr enthalten ist
+    std::lock_guard<std::mutex> saveLock(saveMutex_.m);
+    TrackColumns copy;
+    std::uint64_t covered = 0;
+    std::uint64_t epoch = 0;
+    {
+        std::lock_guard<std::mutex> editLock(editMutex_.m);
+        copy = cols_;
+        covered = journalBytes_;
+        epoch = journalEpoch_;
+    }
+    if (!writeCsvFile(csvPath, copy, threads)) return false;
+
+    std::lock_guard<std::mutex> editLock(editMutex_.m);
+    // Journal inzwischen geschlossen, neu geöffnet oder geleert: nichts zu entfernen.
+    // Nach einem Schreibfehler ist die Länge unsicher, das Journal bleibt dann ganz.
+    if (!journal_.isOpen() || epoch != journalEpoch_ || journalFailed_) return true;
+    if (!journal_.sync()) {
+        journalFailed_ = true;
+        return false;
+    }
+
+    // Neuere Einträge (nach der Kopie angehängt) hinter den Kopf übernehmen
+    std::string kept(kJournalMagic, sizeof(kJournalMagic));
+    if (journalBytes_ > covered) {
+        std::ifstream in(journal_.path(), std::ios::binary);
+        in.seekg(static_cast<std::streamoff>(covered));
+        kept.resize(kept.size() + static_cast<size_t>(journalBytes_ - covered));
+        in.read(&kept[sizeof(kJournalMagic)], static_cast<std::streamsize>(journalBytes_ - covered));
+        if (!in) return false;
+    }
+    if (!journal_.replace(kept.data(), kept.size())) {
+        journalFailed_ = true;
+        return false;
+    }
+    journalBytes_ = kept.size();
+    ++journalEpoch_;
+    journalPending_ = 0;
+    return true;
+}
+
+bool MusicLibrary::saveSnapshot(const std::string& path) const {    //Bib als Binär-Snapshot speichern
+    // Wie beim CSV erst in eine temporäre Datei schreiben und dann umbenennen: die alte
+    // Datei bleibt bei einem Absturz erhalten, und wer sie eingeblendet hat (MappedLibrary),
+    // behält die alten Daten statt abgeschnittener Seiten
+    const std::string tmpPath = path + ".tmp";
+    std::FILE* file = std::fopen(tmpPath.c_str(), "wb");
+    if (!file) return false;
+    bool ok = true;
+    auto put = [&](const void* data, std::uint64_t n) {
+        ok = ok && (n == 0 || std::fwrite(data, 1, static_cast<size_t>(n), file) == n);
+    };
+
+    // Das Format kennt keine Grabsteine: dann eine verdichtete Kopie schreiben
+    TrackColumns compacted;
+    const TrackColumns* source = &cols_;
+    if (cols_.deletedCount() > 0) {
+        compacted = cols_;
+        compacted.compact();
+        source = &compacted;
+    }
+    const TrackColumns& cols = *source;
+
+    const std::uint64_t count = cols.size();
+    const StringDictionary* dicts[3] = { &cols.artistDict(), &cols.albumDict(), &cols.genreDict() };
+    const std::vector<std::uint32_t>* codes[3] = { &cols.artistCodes(), &cols.albumCodes(), &cols.genreCodes() };
+
+    // Texttabelle c: Titel je Slot, sonst die Einträge des Wörterbuchs (Codes bleiben gleich)
+    auto entries = [&](int c) -> std::uint64_t { return c == 0 ? count : dicts[c - 1]->size(); };
+    auto entry = [&](int c, size_t i) -> std::string_view { return c == 0 ? cols.view(i).title : (*dicts[c - 1])[static_cast<std::uint32_t>(i)]; };
+
+    SnapshotHeader h{};
+    std::memcpy(h.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+    h.version = kSnapshotVersion;
+    h.byteOrder = kSnapshotByteOrder;
+    h.count = count;
+    h.flags = kSnapshotIdsSorted;
+    const std::vector<int>& ids = cols.ids();
+    for (size_t i = 1; i < ids.size(); ++i) {
+        if (ids[i - 1] >= ids[i]) {
+            h.flags &= ~kSnapshotIdsSorted;
+            break;
+        }
+    }
+    for (int c = 0; c < 4; ++c) {
+        for (size_t i = 0; i < entries(c); ++i) h.blobBytes[c] += entry(c, i).size();
+        if (c > 0) h.dictCount[c - 1] = entries(c);
+    }
+    put(&h, sizeof(h));
+
+    static const char zeros[8] = {};
+    auto pad = [&](std::uint64_t written) {
+        put(zeros, align8(written) - written);
+    };
+
+    // Zahlen- und Codespalten liegen schon zusammenhängend vor
+    static_assert(sizeof(int) == 4, "Snapshot erwartet 32-Bit int");
+    const std::vector<int>* numbers[3] = { &cols.ids(), &cols.years(), &cols.durations() };
+    for (const std::vector<int>* column : numbers) {
+        put(column->data(), count * 4);
+        pad(count * 4);
+    }
+    for (const std::vector<std::uint32_t>* column : codes) {
+        put(column->data(), count * 4);
+        pad(count * 4);
+    }
+
+    // Offset-Tabellen, danach die Blobs
+    std::vector<std::uint64_t> offsets;
+    for (int c = 0; c < 4; ++c) {
+        offsets.assign(entries(c) + 1, 0);
+        for (size_t i = 0; i < entries(c); ++i) offsets[i + 1] = offsets[i] + entry(c, i).size();
+        put(offsets.data(), offsets.size() * 8);
+    }
+    for (int c = 0; c < 4; ++c) {
+        for (size_t i = 0; i < entries(c); ++i) {
+            std::string_view str = entry(c, i);
+            put(str.data(), str.size());
+        }
+        pad(h.blobBytes[c]);
+    }
+
+    ok = syncFile(file) && ok;
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return commitTempFile(tmpPath, path);
+}
+
+bool MusicLibrary::loadSnapshot(const std::string& path) {          //Bib aus Binär-Snapshot laden
+    auto started = std::chrono::steady_clock::now();
+
+    MappedFile file(path);
+    if (!file.isOpen()) return false;
+
+    // Erst vollständig prüfen, dann erst die aktuelle Bib ersetzen
+    SnapshotLayout l;
+    if (!validateSnapshot(file.data(), file.size(), l)) return false;
+
+    clear();
+    std::lock_guard<std::mutex> lock(editMutex_.m);
+    loadStats_ = LoadStats{};
+    rejected_.clear();
+
+    const char* d = file.data();
+    const size_t count = static_cast<size_t>(l.count);
+    if (l.version >= 2) {
+        // Spalten, Wörterbücher und Codes liegen fertig vor: am Stück übernehmen
+        PackedTexts texts[4];
+        for (int c = 0; c < 4; ++c) {
+            texts[c].blob = d + l.blobs[c];
+            texts[c].blobBytes = l.blobBytes[c];
+            texts[c].offsets = d + l.offsets[c];
+            texts[c].count = static_cast<size_t>(l.entries[c]);
+        }
+        const char* const codes[3] = { d + l.codes[0], d + l.codes[1], d + l.codes[2] };
+        const PackedTexts dicts[3] = { texts[1], texts[2], texts[3] };
+        cols_.assignPacked(count, d + l.ids, d + l.years, d + l.durations, texts[0], codes, dicts);
+    }
+    else {
+        // Version 1: Texte je Track, Wörterbücher entstehen beim Einfügen
+        std::string_view MusicTrackView::* columns[4] = {
+            &MusicTrackView::title, &MusicTrackView::artist, &MusicTrackView::album, &MusicTrackView::genre
+        };
+        cols_.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            MusicTrackView t;
+            t.id = readRaw<std::int32_t>(d + l.ids + i * 4);
+            t.year = readRaw<std::int32_t>(d + l.years + i * 4);
+            t.durationSec = readRaw<std::int32_t>(d + l.durations + i * 4);
+            for (int c = 0; c < 4; ++c) t.*columns[c] = packedAt(d + l.blobs[c], d + l.offsets[c], i);
+            cols_.push_back(t);
+        }
+    }
+
+    refreshNextId_();
+
+    loadStats_.bytes = file.size();
+    loadStats_.rows = cols_.size();
+    loadStats_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return true;
+}
+    
+int MusicLibrary::addTrack(const MusicTrack& t) {                   //neuen Track hinzufügen
+    return addTrack(MusicTrack(t));
+}
+
+int MusicLibrary::addTrack(MusicTrack&& t) {                        //neuen Track übernehmen
+    sanitizeTrack_(t);
+
+    std::lock_guard<std::mutex> lock(editMutex_.m);
+    t.id = nextId_++;
+    cols_.push_back(t);
+    journalAppend_(kJournalAdd, t);
+    return t.id;
+}
+
+int MusicLibrary::addTracks(std::vector<MusicTrack> tracks, unsigned threads) {    //viele Tracks hinzufügen
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Bereinigen braucht keinen Lock, die Tracks gehören noch dem Aufrufer
+    size_t workers = std::min<size_t>(threads, tracks.size() / kParallelSanitizeMin);
+    if (workers <= 1) {
+        for (auto& t : tracks) sanitizeTrack_(t);
+    }
+    else {
+        std::vector<std::exception_ptr> errors(workers);
+        std::vector<std::thread> pool;
+        ThreadJoiner joiner(pool);
+        pool.reserve(workers);
+        for (size_t w = 0; w < workers; ++w) {
+            size_t from = tracks.size() / workers * w;
+            size_t to = w + 1 == workers ? tracks.size() : tracks.size() / workers * (w + 1);
+            pool.emplace_back([&, from, to, w] {
+                try {
+                    for (size_t i = from; i < to; ++i) sanitizeTrack_(tracks[i]);
+                }
+                catch (...) {
+                    errors[w] = std::current_exception();
+                }
+            });
+        }
+        joiner.join();
+        for (auto& e : errors) {
+            if (e) std::rethrow_exception(e);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(editMutex_.m);
+    const int first = nextId_;
+
+    // Einmal reservieren, bei vielen kleinen Batches trotzdem geometrisch wachsen
+    size_t needed = cols_.slotCount() + tracks.size();
+    if (needed > cols_.capacity()) {
+        cols_.reserve(std::max(needed, cols_.capacity() * 2));
+    }
+
+    for (auto& t : tracks) {
+        t.id = nextId_++;
+        cols_.push_back(t);
+        journalAppend_(kJournalAdd, t);
+    }
+    return first;
+}
+
+bool MusicLibrary::updateTrack(int id, const MusicTrack& t) {       //Track aktualisieren
+    std::lock_guard<std::mutex> lock(editMutex_.m);
+    size_t slot = cols_.find(id);
+    if (slot == TrackColumns::npos) return false;
+
+    MusicTrack track;
+    track.id = id;
+    track.title = sanitize(t.title);
+    track.artist = sanitize(t.artist);
+    track.album = sanitize(t.album);
+    track.year = t.year;
+    track.genre = sanitize(t.genre);
+    track.durationSec = t.durationSec;
+    cols_.assign(slot, track);
+    journalAppend_(kJournalUpdate, track);
+    return true;
+}
+    
+bool MusicLibrary::deleteTrack(int id) {                            //Track löschen
+    std::lock_guard<std::mutex> lock(editMutex_.m);
+    size_t slot = cols_.find(id);
+    if (slot == TrackColumns::npos) return false;
+
+    MusicTrack removed;
+    removed.id = id;
+    cols_.erase(slot);
+    journalAppend_(kJournalDelete, removed);
+
+    // Verdichten kostet O(n), passiert aber erst nach vielen Löschungen
+    if (cols_.deletedCount() > compactionRatio_ * cols_.slotCount()) {
+        cols_.compact();
+    }
+    return true;
+}
+
+bool MusicLibrary::openJournal(const std::string& path, std::size_t syncEvery) {   //Journal anwenden und öffnen
+    closeJournal();
+
+    std::error_code ec;
+    std::uintmax_t existing = std::filesystem::exists(path, ec) ? std::filesystem::file_size(path, ec) : 0;
+    if (ec) return false;
+
+    if (existing > 0) {
+        size_t validEnd = 0;
+        {
+            MappedFile file(path);
+            if (!file.isOpen()) return false;
+            if (file.size() < sizeof(kJournalMagic) ||
+                std::memcmp(file.data(), kJournalMagic, sizeof(kJournalMagic)) != 0) {
+                return false;       // keine Journal-Datei, nicht überschreiben
+            }
+            std::lock_guard<std::mutex> lock(editMutex_.m);
+            validEnd = replayJournal_(file.data(), file.size());
+        }
+
+        // Abgeschnittenen Rest eines Absturzes entfernen, sonst landen neue Einträge dahinter
+        if (validEnd < existing) {
+            std::filesystem::resize_file(path, validEnd, ec);
+            if (ec) return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(editMutex_.m);     // gegen checkpointCopy im Autosave-Thread
+    if (!journal_.open(path)) return false;
+    if (existing == 0 && !(journal_.append(kJournalMagic, sizeof(kJournalMagic)) && journal_.sync())) {
+        journal_.close();
+        return false;
+    }
+
+    journalSyncEvery_ = syncEvery == 0 ? 1 : syncEvery;
+    journalPending_ = 0;
+    journalFailed_ = false;
+    journalBytes_ = existing == 0 ? sizeof(kJournalMagic) : std::filesystem::file_size(path, ec);
+    ++journalEpoch_;
+    return !ec;
+}
+
+std::size_t MusicLibrary::replayJournal_(const char* data, std::size_t size) {
+    size_t pos = sizeof(kJournalMagic);
+    MusicTrack t;
+    unsigned char type = 0;
+
+    while (size - pos >= 8) {
+        std::uint32_t len = readRaw<std::uint32_t>(data + pos);
+        std::uint32_t sum = readRaw<std::uint32_t>(data + pos + 4);
+        if (size - pos - 8 < len) break;
+        const char* payload = data + pos + 8;
+        if (fnv1a(payload, len) != sum || !decodeJournalRecord(payload, len, type, t)) break;
+
+        // Anwenden ist idempotent: ein Checkpoint kann schon Teile enthalten. Hinzufügen
+        // und Ändern setzen den Track auf den Stand des Eintrags (fehlt er, wird er
+        // angelegt), Löschen entfernt ihn; maßgeblich ist der letzte Eintrag je ID.
+        size_t slot = cols_.find(t.id);
+        if (type == kJournalDelete) {
+            if (slot != TrackColumns::npos) cols_.erase(slot);
+        }
+        else if (slot != TrackColumns::npos) {
+            cols_.assign(slot, t);
+        }
+        else {
+            cols_.push_back(t);
+        }
+        if (t.id >= nextId_ && t.id != INT_MAX) nextId_ = t.id + 1;    // INT_MAX + 1 nicht darstellbar
+
+        pos += 8 + len;
+    }
+    return pos;
+}
+
+void MusicLibrary::journalAppend_(unsigned char type, const MusicTrack& t) {
+    if (!journal_.isOpen()) return;
+
+    encodeJournalRecord(journalBuf_, type, t);
+    if (!journal_.append(journalBuf_.data(), journalBuf_.size())) {
+        journalFailed_ = true;
+        return;
+    }
+    journalBytes_ += journalBuf_.size();
+
+    // fsync gesammelt nach journalSyncEvery_ Einträgen
+    if (++journalPending_ >= journalSyncEvery_) {
+        syncJournal_();
+    }
+}
+
+bool MusicLibrary::syncJournal() {
+    std::lock_guard<std::mutex> lock(editMutex_.m);
+    return syncJournal_();
+}
+
+bool MusicLibrary::syncJournal_() {
+    if (!journal_.isOpen()) return false;
+    if (!journal_.sync()) journalFailed_ = true;
+    journalPending_ = 0;
+    return !journalFailed_;
+}
+
+void MusicLibrary::closeJournal() {
+    std::lock_guard<std::mutex> lock(editMutex_.m);
+    journal_.close();
+    journalPending_ = 0;
+    ++journalEpoch_;
+}
+
+bool MusicLibrary::checkpoint(const std::string& csvPath) {        //Journal in die CSV-Datei übernehmen
+    if (!saveToCsvParallel(csvPath)) return false;
+    std::lock_guard<std::mutex> lock(editMutex_.m);
+    if (!journal_.isOpen()) return true;
+
+    // Erst nach vollständig geschriebener Basis leeren
+    if (!journal_.reset(kJournalMagic, sizeof(kJournalMagic))) {
+        journalFailed_ = true;
+        return false;
+    }
+    journalBytes_ = sizeof(kJournalMagic);
+    ++journalEpoch_;
+    journalPending_ = 0;
+    journalFailed_ = false;
+    return true;
+}
+
+std::optional<MusicTrack> MusicLibrary::findById(int id) const {    //Track suchen nach ID
+    size_t slot = cols_.find(id);
+    if (slot == TrackColumns::npos) return std::nullopt;
+    return cols_.track(slot);
+}
+
+long long MusicLibrary::totalDurationSec() const {                      //Gesamtdauer aller Tracks
+    const std::vector<int>& durations = cols_.durations();
+    long long total = 0;
+    if (cols_.deletedCount() == 0) {
+        for (int d : durations) total += d;
+    }
+    else {
+        for (size_t i = 0; i < durations.size(); ++i) {
+            if (cols_.live(i)) total += durations[i];
+        }
+    }
+    return total;
+}
+
+void MusicLibrary::compact() {                                          //Grabsteine entfernen
+    std::lock_guard<std::mutex> lock(editMutex_.m);
+    cols_.compact();
+}
+
+void MusicLibrary::enableTrigramIndex(bool on) {                        //Trigramm-Index an/aus
+    std::lock_guard<std::mutex> lock(editMutex_.m);
+    cols_.setTrigramIndex(on);
+}
+
+
+
+
+std::vector<MusicTrack> MusicLibrary::search(const std::string& query, Field by) const {    //Track suchen nach string
+    std::vector<MusicTrack> results;
+    forEachMatch(query, by, [&](const MusicTrackView& t) { results.push_back(t.toTrack()); });
+    return results;
+}
+
+std::vector<std::size_t> MusicLibrary::searchSlots(std::string_view query, Field by) const {    //nur Slots der Treffer
+    std::vector<std::size_t> slots;
+    auto visit = [](void* ctx, std::size_t slot, const MusicTrackView&) {
+        static_cast<std::vector<std::size_t>*>(ctx)->push_back(slot);
+        return true;
+    };
+    scanMatches_(query, by, visit, &slots);
+    return slots;
+}
+
+// Slots pro Block der parallelen Suche (Einheit, die sich ein Thread holt)
+static constexpr size_t kSearchBlockSlots = 16 * 1024;
+
+// Slots from..to-1 blockweise auf threads Threads prüfen: scanBlock(lo, hi, out) legt die
+// Treffer eines Blocks in out ab. Die Treffer gehen in Slot-Reihenfolge an emit(slot),
+// sobald der jeweilige Block fertig ist; liefert emit false, hören alle Threads auf.
+template<typename ScanBlock, typename Emit>
+static void parallelScan(size_t from, size_t to, unsigned threads, ScanBlock scanBlock, Emit emit) {
+    const size_t blocks = (to - from + kSearchBlockSlots - 1) / kSearchBlockSlots;
+    const size_t workers = std::min<size_t>(threads, blocks);
+
+    std::vector<std::vector<std::uint32_t>> hits(blocks);
+    std::vector<char> ready(blocks, 0);
+    std::atomic<size_t> nextBlock{ 0 };
+    std::atomic<bool> stop{ false };
+    std::mutex m;
+    std::condition_variable cv;
+    std::vector<std::exception_ptr> errors(workers);
+
+    std::vector<std::thread> pool;
+    ThreadJoiner joiner(pool);
+    pool.reserve(workers);
+    auto work = [&](size_t w) {
+        try {
+            while (!stop.load(std::memory_order_relaxed)) {
+                const size_t b = nextBlock.fetch_add(1);
+                if (b >= blocks) break;
+                const size_t lo = from + b * kSearchBlockSlots;
+                scanBlock(lo, std::min(to, lo + kSearchBlockSlots), hits[b]);
+                {
+                    std::lock_guard<std::mutex> lock(m);
+                    ready[b] = 1;
+                }
+                cv.notify_all();
+            }
+        }
+        catch (...) {
+            errors[w] = std::current_exception();
+            {
+                std::lock_guard<std::mutex> lock(m);
+                stop = true;
+            }
+            cv.notify_all();
+        }
+    };
+    try {
+        for (size_t w = 0; w < workers; ++w) pool.emplace_back(work, w);
+    }
+    catch (const std::system_error&) {
+        // Weniger Threads als gewünscht: die gestarteten holen sich trotzdem alle
+        // Blöcke, ohne einen Thread prüft der aufrufende Thread selbst
+        if (pool.empty()) {
+            for (size_t b = 0; b < blocks; ++b) {
+                const size_t lo = from + b * kSearchBlockSlots;
+                scanBlock(lo, std::min(to, lo + kSearchBlockSlots), hits[b]);
+                for (std::uint32_t slot : hits[b]) {
+                    if (!emit(slot)) return;
+                }
+                std::vector<std::uint32_t>().swap(hits[b]);
+            }
+            return;
+        }
+    }
+    auto finish = [&] {
+        stop = true;
+        joiner.join();
+    };
+
+    try {
+        for (size_t b = 0; b < blocks; ++b) {
+            {
+                std::unique_lock<std::mutex> lock(m);
+                cv.wait(lock, [&] { return ready[b] || stop; });
+                if (!ready[b]) break;                   // ein Thread ist ausgefallen
+            }
+            bool more = true;
+            for (std::uint32_t slot : hits[b]) {
+                if (!(more = emit(slot))) break;
+            }
+            if (!more) break;
+            std::vector<std::uint32_t>().swap(hits[b]);
+        }
+    }
+    catch (...) {
+        finish();                                       // Threads greifen auf diesen Stack zu
+        throw;
+    }
+    finish();
+    for (auto& e : errors) {
+        if (e) std::rethrow_exception(e);
+    }
+}
+
+unsigned MusicLibrary::searchThreadsFor_(std::size_t slots) const {
+    if (slots < parallelSearchMin_ || slots <= kSearchBlockSlots) return 1;
+    return searchThreads_ == 0 ? std::max(1u, std::thread::hardware_concurrency()) : searchThreads_;
+}
+
+void MusicLibrary::setParallelSearch(unsigned threads, std::size_t minSlots) {
+    searchThreads_ = threads;
+    parallelSearchMin_ = minSlots;
+}
+
+void MusicLibrary::scanMatches_(std::string_view query, Field by, MatchVisitor visit, void* ctx, std::size_t fromSlot) const {
+    // Suchbegriff einmal falten, pro Zeile bleibt eine reine Teilstring-Suche
+    // auf den Schattenspalten (bzw. ein Nachschlagen über den Code)
+    const std::string folded = foldCase(query);
+    const std::optional<int> year = yearQuery(query);
+    const std::vector<int>& years = cols_.years();
+
+    std::vector<char> artistHit, albumHit, genreHit;
+    if (by == Field::Artist || by == Field::Any) artistHit = dictionaryMatches(cols_.artistDict(), folded);
+    if (by == Field::Album || by == Field::Any) albumHit = dictionaryMatches(cols_.albumDict(), folded);
+    if (by == Field::Genre || by == Field::Any) genreHit = dictionaryMatches(cols_.genreDict(), folded);
+
+    auto titleHit = [&](size_t i) {
+        return containsFolded(cols_.foldedTitle(i), folded);
+    };
+    auto yearHit = [&](size_t i) {
+        return year && years[i] == *year;
+    };
+
+    // Jahr über den sortierten Index: gleiche Jahre liegen nach Slot sortiert beieinander
+    if (by == Field::Year) {
+        if (!year) return;
+        auto [first, last] = rangeInOrder(cols_, RangeField::Year, *year, *year);
+        first = std::lower_bound(first, last, fromSlot,
+            [](std::uint32_t slot, size_t from) { return slot < from; });
+        for (; first != last; ++first) {
+            if (cols_.live(*first) && !visit(ctx, *first, cols_.view(*first))) return;
+        }
+        return;
+    }
+
+    // Mit Trigramm-Index kommen für den Titel nur die Kandidaten-Slots in Frage
+    std::vector<std::uint32_t> titleCandidates;
+    const bool titleIndexed = (by == Field::Title || by == Field::Any) && cols_.trigramIndexed() &&
+        cols_.titleTrigrams().candidates(folded, titleCandidates);
+    auto candidate = std::lower_bound(titleCandidates.begin(), titleCandidates.end(),
+        static_cast<std::uint32_t>(std::min<size_t>(fromSlot, UINT32_MAX)));
+
+    if (titleIndexed && by == Field::Title) {
+        for (; candidate != titleCandidates.end(); ++candidate) {
+            size_t i = *candidate;
+            if (cols_.live(i) && titleHit(i) && !visit(ctx, i, cols_.view(i))) return;
+        }
+        return;
+    }
+
+    // Prüft einen lebenden Slot. cursor läuft aufsteigend durch die Titel-Kandidaten,
+    // bei paralleler Suche hat jeder Block seinen eigenen.
+    using Cursor = std::vector<std::uint32_t>::const_iterator;
+    auto rowHit = [&](size_t i, Cursor& cursor) {
+        switch (by) {
+        case Field::Any:
+            if (artistHit[cols_.artistCodes()[i]] || albumHit[cols_.albumCodes()[i]] ||
+                genreHit[cols_.genreCodes()[i]] || yearHit(i)) return true;
+            if (!titleIndexed) return titleHit(i);
+            while (cursor != titleCandidates.end() && *cursor < i) ++cursor;
+            return cursor != titleCandidates.end() && *cursor == i && titleHit(i);
+        case Field::Title:  return titleHit(i);
+        case Field::Artist: return static_cast<bool>(artistHit[cols_.artistCodes()[i]]);
+        case Field::Album:  return static_cast<bool>(albumHit[cols_.albumCodes()[i]]);
+        case Field::Genre:  return static_cast<bool>(genreHit[cols_.genreCodes()[i]]);
+        default:            return yearHit(i);
+        }
+    };
+
+    const size_t end = cols_.slotCount();
+    const unsigned threads = fromSlot < end ? searchThreadsFor_(end - fromSlot) : 1;
+    if (threads > 1) {
+        parallelScan(fromSlot, end, threads,
+            [&](size_t lo, size_t hi, std::vector<std::uint32_t>& out) {
+                Cursor cursor = std::lower_bound(titleCandidates.cbegin(), titleCandidates.cend(),
+                    static_cast<std::uint32_t>(lo));
+                for (size_t i = lo; i < hi; ++i) {
+                    if (cols_.live(i) && rowHit(i, cursor)) out.push_back(static_cast<std::uint32_t>(i));
+                }
+            },
+            [&](size_t slot) { return visit(ctx, slot, cols_.view(slot)); });
+        return;
+    }
+
+    Cursor cursor = candidate;
+    for (size_t i = fromSlot; i < end; ++i) {
+        if (cols_.live(i) && rowHit(i, cursor) && !visit(ctx, i, cols_.view(i))) return;
+    }
+}
+
+TrackPage MusicLibrary::listPage(std::size_t offset, std::size_t limit) const {     //Seite aller Tracks
+    // Ohne Grabsteine ist der offset-te Track direkt der Slot offset
+    size_t slot = 0;
+    if (cols_.deletedCount() == 0) {
+        slot = std::min(offset, cols_.slotCount());
+    }
+    else {
+        for (; slot < cols_.slotCount(); ++slot) {
+            if (cols_.live(slot) && offset-- == 0) break;
+        }
+    }
+
+    TrackPage page;
+    listFrom_(slot, limit, page);
+    return page;
+}
+
+TrackPage MusicLibrary::searchPage(std::string_view query, Field by, std::size_t offset, std::size_t limit) const {
+    TrackPage page;
+    searchFrom_(query, by, 0, offset, limit, page);
+    return page;
+}
+
+bool MusicLibrary::listNext(const PageToken& from, std::size_t limit, TrackPage& out) const {
+    out.tracks.clear();
+    out.more = false;
+    if (from.slot != 0 && from.layout != cols_.layout()) return false;
+    listFrom_(from.slot, limit, out);
+    return true;
+}
+
+bool MusicLibrary::searchNext(std::string_view query, Field by, const PageToken& from,
+    std::size_t limit, TrackPage& out) const {
+    out.tracks.clear();
+    out.more = false;
+    if (from.slot != 0 && from.layout != cols_.layout()) return false;
+    searchFrom_(query, by, from.slot, 0, limit, out);
+    return true;
+}
+
+void MusicLibrary::listFrom_(std::size_t slot, std::size_t limit, TrackPage& out) const {
+    out.tracks.reserve(std::min(limit, cols_.size()));
+    for (; slot < cols_.slotCount() && out.tracks.size() < limit; ++slot) {
+        if (cols_.live(slot)) out.tracks.push_back(cols_.track(slot));
+    }
+
+    // Nächsten lebenden Track suchen, damit more stimmt
+    while (slot < cols_.slotCount() && !cols_.live(slot)) ++slot;
+    out.more = slot < cols_.slotCount();
+    out.next.slot = slot;
+    out.next.layout = cols_.layout();
+}
+
+void MusicLibrary::searchFrom_(std::string_view query, Field by, std::size_t slot, std::size_t skip,
+    std::size_t limit, TrackPage& out) const {
+    struct Fill {
+        TrackPage* out;
+        size_t skip;
+        size_t limit;
+    } fill{ &out, skip, limit };
+
+    // Ein Treffer über die Seite hinaus wird nur noch als Fortsetzungspunkt gemerkt
+    auto visit = [](void* ctx, std::size_t at, const MusicTrackView& v) {
+        Fill& f = *static_cast<Fill*>(ctx);
+        if (f.skip > 0) {
+            --f.skip;
+            return true;
+        }
+        if (f.out->tracks.size() < f.limit) {
+            f.out->tracks.push_back(v.toTrack());
+            return true;
+        }
+        f.out->more = true;
+        f.out->next.slot = at;
+        return false;
+    };
+
+    out.more = false;
+    out.next.slot = cols_.slotCount();
+    out.next.layout = cols_.layout();
+    scanMatches_(query, by, visit, &fill, slot);
+}
+
+std::vector<std::size_t> MusicLibrary::searchRangeSlots(RangeField by, int lo, int hi) const {    //Bereich über Index
+    auto [first, last] = rangeInOrder(cols_, by, lo, hi);
+    std::vector<std::size_t> slots;
+    slots.reserve(static_cast<size_t>(last - first));
+    for (; first != last; ++first) {
+        if (cols_.live(*first)) slots.push_back(*first);
+    }
+    return slots;
+}
+
+std::vector<MusicTrack> MusicLibrary::searchRange(RangeField by, int lo, int hi) const {    //Bereich als Kopien
+    std::vector<MusicTrack> out;
+    for (size_t slot : searchRangeSlots(by, lo, hi)) out.push_back(cols_.track(slot));
+    return out;
+}
+
+std::vector<std::size_t> MusicLibrary::querySlots(const Query& q) const {    //Abfrage nach Plan
+    const QueryPlan plan = planQuery(q, cols_);
+    std::vector<std::size_t> slots;
+
+    // Mit Index nur die Kandidaten prüfen, sonst alle Zeilen
+    if (plan.indexed) {
+        std::vector<std::uint32_t> candidates;
+        planCandidates(plan, cols_, candidates);
+        for (std::uint32_t slot : candidates) {
+            if (cols_.live(slot) && planHit(plan, cols_, slot)) slots.push_back(slot);
+        }
+        return slots;
+    }
+    const unsigned threads = searchThreadsFor_(cols_.slotCount());
+    if (threads > 1) {
+        parallelScan(0, cols_.slotCount(), threads,
+            [&](size_t lo, size_t hi, std::vector<std::uint32_t>& out) {
+                for (size_t slot = lo; slot < hi; ++slot) {
+                    if (cols_.live(slot) && planHit(plan, cols_, slot)) out.push_back(static_cast<std::uint32_t>(slot));
+                }
+            },
+            [&](size_t slot) {
+                slots.push_back(slot);
+                return true;
+            });
+        return slots;
+    }
+    for (size_t slot = 0; slot < cols_.slotCount(); ++slot) {
+        if (cols_.live(slot) && planHit(plan, cols_, slot)) slots.push_back(slot);
+    }
+    return slots;
+}
+
+std::vector<MusicTrack> MusicLibrary::query(const Query& q) const {    //Abfrage als Kopien
+    std::vector<MusicTrack> out;
+    for (size_t slot : querySlots(q)) out.push_back(cols_.track(slot));
+    return out;
+}
+
+// Die k besten Vorschläge: mehr Tracks zuerst, bei Gleichstand der früher angebotene
+// (Werte kommen alphabetisch an). Hält nur k Einträge als Heap, der schlechteste oben.
+class TopSuggestions {
+public:
+    explicit TopSuggestions(size_t k) : k_(k) {}
+
+    void offer(std::string_view text, size_t count) {
+        if (k_ == 0 || count == 0) return;
+        Entry e{ text, count, rank_++ };
+        if (heap_.size() < k_) {
+            heap_.push_back(e);
+            std::push_heap(heap_.begin(), heap_.end(), better);
+        }
+        else if (better(e, heap_.front())) {
+            std::pop_heap(heap_.begin(), heap_.end(), better);
+            heap_.back() = e;
+            std::push_heap(heap_.begin(), heap_.end(), better);
+        }
+    }
+
+    std::vector<Suggestion> take() {
+        std::sort_heap(heap_.begin(), heap_.end(), better);
+        std::vector<Suggestion> out;
+        out.reserve(heap_.size());
+        for (const Entry& e : heap_) out.push_back(Suggestion{ std::string(e.text), e.count });
+        return out;
+    }
+
+private:
+    struct Entry {
+        std::string_view text;
+        size_t count;
+        size_t rank;
+    };
+    static bool better(const Entry& a, const Entry& b) {
+        return a.count != b.count ? a.count > b.count : a.rank < b.rank;
+    }
+
+    size_t k_;
+    size_t rank_{ 0 };
+    std::vector<Entry> heap_;
+};
+
+static bool startsWith(std::string_view s, std::string_view prefix) {
+    return s.size() >= prefix.size() && s.compare(0, prefix.size(), prefix) == 0;
+}
+
+// Vorschläge aus einem Wörterbuch: gleiche gefaltete Einträge werden zusammengezählt,
+// angezeigt wird die häufigste Schreibweise
+static void suggestFromDictionary(const StringDictionary& dict, const std::vector<std::uint32_t>& uses,
+    std::string_view folded, TopSuggestions& top) {
+    const std::vector<std::uint32_t>& order = dict.sortedCodes();
+    auto it = std::lower_bound(order.begin(), order.end(), folded,
+        [&](std::uint32_t code, std::string_view key) { return dict.folded(code) < key; });
+
+    while (it != order.end() && startsWith(dict.folded(*it), folded)) {
+        const std::string_view group = dict.folded(*it);
+        size_t total = 0, best = 0;
+        std::uint32_t bestCode = *it;
+        for (; it != order.end() && dict.folded(*it) == group; ++it) {
+            size_t n = *it < uses.size() ? uses[*it] : 0;
+            total += n;
+            if (n > best) {
+                best = n;
+                bestCode = *it;
+            }
+        }
+        top.offer(dict[bestCode], total);
+    }
+}
+
+std::vector<Suggestion> MusicLibrary::suggest(std::string_view prefix, Field by, std::size_t k) const {    //Vervollständigung
+    const std::string folded = foldCase(prefix);
+    TopSuggestions top(k);
+
+    switch (by) {
+    case Field::Artist: suggestFromDictionary(cols_.artistDict(), cols_.artistUses(), folded, top); break;
+    case Field::Album:  suggestFromDictionary(cols_.albumDict(), cols_.albumUses(), folded, top); break;
+    case Field::Genre:  suggestFromDictionary(cols_.genreDict(), cols_.genreUses(), folded, top); break;
+    case Field::Title: {
+        // Gleiche Titel liegen in der Ordnung nebeneinander, gezählt werden lebende Slots
+        const std::vector<std::uint32_t>& order = cols_.titleOrder();
+        auto it = std::lower_bound(order.begin(), order.end(), std::string_view(folded),
+            [&](std::uint32_t slot, std::string_view key) { return cols_.foldedTitle(slot) < key; });
+
+        while (it != order.end() && startsWith(cols_.foldedTitle(*it), folded)) {
+            const std::string_view group = cols_.foldedTitle(*it);
+            size_t total = 0;
+            size_t first = TrackColumns::npos;
+            for (; it != order.end() && cols_.foldedTitle(*it) == group; ++it) {
+                if (!cols_.live(*it)) continue;
+                if (total++ == 0) first = *it;
+            }
+            if (total > 0) top.offer(cols_.view(first).title, total);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return top.take();
+}
+
+
+
+void MusicLibrary::clear() {                                            //Bib leeren
+    std::lock_guard<std::mutex> lock(editMutex_.m);
+    cols_.clear();
+    nextId_ = 1;
+}
+
+void MusicLibrary::sanitizeInPlace(std::string& s) {
+    std::string_view trimmed = trimView(s);
+    size_t start = static_cast<size_t>(trimmed.data() - s.data());
+    s.erase(start + trimmed.size());
+    s.erase(0, start);
+    for (auto& ch : s) {
+        if (ch == '\r' || ch == '\n') ch = ' ';
+    }
+}
+
+void MusicLibrary::sanitizeTrack_(MusicTrack& t) {
+    sanitizeInPlace(t.title);
+    sanitizeInPlace(t.artist);
+    sanitizeInPlace(t.album);
+    sanitizeInPlace(t.genre);
+}
+
+std::string MusicLibrary::sanitize(const std::string& s) {
+    std::string result = trim(s);
+    for (auto& ch : result) {
+        if (ch == '\r' || ch == '\n') ch = ' ';
+    }
+    return result;
+}
+
+std::string MusicLibrary::toCsvRow(const MusicTrack& t) {                   //Wandelt Trach zu CSV Zeile um
+    std::string row;
+    appendCsvRow(row, t);
+    return row;
+}
+
+bool MusicLibrary::fromCsvRow(std::string_view row, MusicTrack& out) {          //Wandelt Track von CSV Zeiele um für UI
+    CsvRowError err;
+    return fromCsvRow(row, out, err);
+}
+
+bool MusicLibrary::fromCsvRow(std::string_view row, MusicTrack& out, CsvRowError& error) {
+    error = parseCsvRow(row, out);
+    return error.code == CsvError::None;
+}
+
+void MusicLibrary::refreshNextId_() {
+    int maxId = 0;
+    for (int id : cols_.ids()) {
+        if (id > maxId && id != INT_MAX) maxId = id;   // wie beim Journal: INT_MAX zählt nicht
+    }
+    nextId_ = maxId + 1;
+}
+
+
+
+//--------------------------------- StringArena ---------------------------------------
+
+char* StringArena::allocate_(std::size_t n) {
+    // Passt nicht mehr: nächsten vorhandenen Block nehmen oder einen neuen einschieben
+    if (chunks_.empty() || chunks_[current_].size - used_ < n) {
+        if (!chunks_.empty()) ++current_;
+        if (current_ == chunks_.size() || chunks_[current_].size < n) {
+            Chunk chunk;
+            chunk.size = std::max(kChunkBytes, n);
+            chunk.data.reset(new char[chunk.size]);
+            chunks_.insert(chunks_.begin() + static_cast<std::ptrdiff_t>(current_), std::move(chunk));
+        }
+        used_ = 0;
+    }
+
+    char* dst = chunks_[current_].data.get() + used_;
+    used_ += n;
+    return dst;
+}
+
+std::string_view StringArena::store(std::string_view s) {
+    if (s.empty()) return std::string_view();
+    char* dst = allocate_(s.size());
+    std::memcpy(dst, s.data(), s.size());
+    return std::string_view(dst, s.size());
+}
+
+std::string_view StringArena::storeFolded(std::string_view s) {
+    if (!hasUpperAscii(s)) return s;
+
+    // Kopieren und falten in einem Durchgang; ohne Verzweigung, damit der Compiler
+    // die Schleife vektorisiert (große Blöcke beim Laden eines Snapshots)
+    char* dst = allocate_(s.size());
+    const unsigned char* src = reinterpret_cast<const unsigned char*>(s.data());
+    for (size_t i = 0; i < s.size(); ++i) {
+        const unsigned char ch = src[i];
+        dst[i] = static_cast<char>(ch + ((static_cast<unsigned char>(ch - 'A') < 26) << 5));
+    }
+    return std::string_view(dst, s.size());
+}
+
+void StringArena::clear() {
+    current_ = 0;
+    used_ = 0;
+}
+
+std::size_t StringArena::bytesUsed() const {
+    if (chunks_.empty()) return 0;
+    std::size_t total = used_;
+    for (size_t i = 0; i < current_; ++i) total += chunks_[i].size;
+    return total;
+}
+
+std::size_t StringArena::bytesReserved() const {
+    std::size_t total = 0;
+    for (const auto& c : chunks_) total += c.size;
+    return total;
+}
+
+
+
+//--------------------------------- TrigramIndex ---------------------------------------
+
+// Verschiedene Trigramme eines Texts (aufsteigend, ohne Doppelte)
+static void collectTrigrams(std::string_view folded, std::vector<std::uint32_t>& out) {
+    out.clear();
+    for (size_t i = 0; i + 3 <= folded.size(); ++i) {
+        out.push_back(static_cast<std::uint32_t>(static_cast<unsigned char>(folded[i])) << 16 |
+            static_cast<std::uint32_t>(static_cast<unsigned char>(folded[i + 1])) << 8 |
+            static_cast<std::uint32_t>(static_cast<unsigned char>(folded[i + 2])));
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+void TrigramIndex::add(std::uint32_t id, std::string_view folded) {
+    std::vector<std::uint32_t> grams;
+    collectTrigrams(folded, grams);
+    for (std::uint32_t g : grams) {
+        Posting& p = postings_[g];
+        // Neue Einträge kommen fast immer hinten dazu, alles andere wird vorgemerkt
+        if (p.pending.empty() && (p.ids.empty() || p.ids.back() < id)) p.ids.push_back(id);
+        else mark_(g, p, id, true);
+    }
+}
+
+void TrigramIndex::remove(std::uint32_t id, std::string_view folded) {
+    std::vector<std::uint32_t> grams;
+    collectTrigrams(folded, grams);
+    for (std::uint32_t g : grams) {
+        auto found = postings_.find(g);
+        if (found == postings_.end()) continue;
+        Posting& p = found->second;
+        if (!p.pending.empty()) {
+            mark_(g, p, id, false);
+        }
+        else if (!p.ids.empty() && p.ids.back() == id) {
+            p.ids.pop_back();
+            if (p.ids.empty()) postings_.erase(found);
+        }
+        else if (std::binary_search(p.ids.begin(), p.ids.end(), id)) {
+            mark_(g, p, id, false);
+        }
+    }
+}
+
+void TrigramIndex::mark_(std::uint32_t gram, Posting& p, std::uint32_t id, bool add) {
+    p.pending.push_back(static_cast<std::uint64_t>(id) << 1 | (add ? 1 : 0));
+    // Puffer höchstens so groß wie die Liste halten: dann kostet das Einarbeiten in
+    // candidates() nicht mehr als die Liste selbst, hier amortisiert O(1) je Änderung
+    if (p.pending.size() > std::max<size_t>(p.ids.size(), 64)) {
+        p.ids = settled_(p);
+        std::vector<std::uint64_t>().swap(p.pending);
+        if (p.ids.empty()) postings_.erase(gram);
+    }
+}
+
+std::vector<std::uint32_t> TrigramIndex::settled_(const Posting& p) {
+    // Je id zählt nur die letzte Änderung
+    std::vector<std::uint64_t> pending = p.pending;
+    std::stable_sort(pending.begin(), pending.end(),
+        [](std::uint64_t a, std::uint64_t b) { return (a >> 1) < (b >> 1); });
+    std::vector<std::uint32_t> adds, drops;
+    for (size_t i = 0; i < pending.size(); ++i) {
+        if (i + 1 < pending.size() && (pending[i + 1] >> 1) == (pending[i] >> 1)) continue;
+        (pending[i] & 1 ? adds : drops).push_back(static_cast<std::uint32_t>(pending[i] >> 1));
+    }
+
+    std::vector<std::uint32_t> kept, merged;
+    kept.reserve(p.ids.size());
+    std::set_difference(p.ids.begin(), p.ids.end(), drops.begin(), drops.end(), std::back_inserter(kept));
+    merged.reserve(kept.size() + adds.size());
+    std::set_union(kept.begin(), kept.end(), adds.begin(), adds.end(), std::back_inserter(merged));
+    return merged;
+}
+
+bool TrigramIndex::candidates(std::string_view folded, std::vector<std::uint32_t>& out) const {
+    out.clear();
+    if (folded.size() < 3) return false;
+
+    std::vector<std::uint32_t> grams;
+    collectTrigrams(folded, grams);
+
+    // Kürzeste Liste zuerst, dann nacheinander schneiden. Vorgemerkte Änderungen
+    // werden nur in eine Kopie eingearbeitet, der Index selbst bleibt unverändert
+    // (gleichzeitige Suchen und Kopien lesen nur).
+    std::vector<const std::vector<std::uint32_t>*> lists;
+    std::vector<std::vector<std::uint32_t>> settled;
+    settled.reserve(grams.size());
+    for (std::uint32_t g : grams) {
+        auto it = postings_.find(g);
+        if (it == postings_.end()) return true;         // ein Trigramm kommt nirgends vor
+        if (it->second.pending.empty()) {
+            lists.push_back(&it->second.ids);
+            continue;
+        }
+        settled.push_back(settled_(it->second));
+        if (settled.back().empty()) return true;
+        lists.push_back(&settled.back());
+    }
+    std::sort(lists.begin(), lists.end(),
+        [](const auto* a, const auto* b) { return a->size() < b->size(); });
+
+    out = *lists[0];
+    std::vector<std::uint32_t> next;
+    for (size_t k = 1; k < lists.size() && !out.empty(); ++k) {
+        next.clear();
+        std::set_intersection(out.begin(), out.end(), lists[k]->begin(), lists[k]->end(),
+            std::back_inserter(next));
+        out.swap(next);
+    }
+    return true;
+}
+
+
+
+//--------------------------------- StringDictionary ---------------------------------------
+
+StringDictionary::StringDictionary(const StringDictionary& other) : indexed_(other.indexed_) {
+    // Sichten zeigen in die Arena des Originals, daher Texte neu ablegen
+    // (der Trigramm-Index entsteht dabei über intern neu)
+    values_.reserve(other.values_.size());
+    folded_.reserve(other.values_.size());
+    index_.reserve(other.values_.size());
+    for (std::string_view v : other.values_) intern(v);
+}
+
+StringDictionary& StringDictionary::operator=(const StringDictionary& other) {
+    if (this != &other) {
+        StringDictionary copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+std::uint32_t StringDictionary::intern(std::string_view s) {
+    auto it = index_.find(s);
+    if (it != index_.end()) return it->second;
+
+    std::uint32_t code = static_cast<std::uint32_t>(values_.size());
+    values_.push_back(arena_.store(s));
+    folded_.push_back(arena_.storeFolded(values_.back()));
+    index_.emplace(values_.back(), code);
+    if (indexed_) trigrams_.add(code, folded_.back());
+    return code;
+}
+
+void StringDictionary::setTrigramIndex(bool on) {
+    if (on == indexed_) return;
+    indexed_ = on;
+    trigrams_.clear();
+    if (!on) return;
+    for (std::uint32_t code = 0; code < folded_.size(); ++code) trigrams_.add(code, folded_[code]);
+}
+
+const std::vector<std::uint32_t>& StringDictionary::sortedCodes() const {
+    std::lock_guard<std::mutex> lock(sortMutex_.m);
+    const size_t done = sorted_.size();
+    if (done == folded_.size()) return sorted_;
+
+    // Bei gleichem gefalteten Eintrag entscheidet der Code, damit die Ordnung eindeutig ist
+    auto less = [this](std::uint32_t a, std::uint32_t b) {
+        return folded_[a] != folded_[b] ? folded_[a] < folded_[b] : a < b;
+    };
+    for (size_t code = done; code < folded_.size(); ++code) sorted_.push_back(static_cast<std::uint32_t>(code));
+    std::sort(sorted_.begin() + done, sorted_.end(), less);
+    std::inplace_merge(sorted_.begin(), sorted_.begin() + done, sorted_.end(), less);
+    return sorted_;
+}
+
+void StringDictionary::assignPacked(const PackedTexts& texts) {
+    clear();
+
+    // Alle Texte mit einer Kopie in die Arena, die Einträge zeigen hinein
+    const char* base = arena_.store(std::string_view(texts.blob, static_cast<size_t>(texts.blobBytes))).data();
+    values_.reserve(texts.count);
+    folded_.reserve(texts.count);
+    index_.reserve(texts.count);
+    for (size_t i = 0; i < texts.count; ++i) {
+        const std::uint32_t code = static_cast<std::uint32_t>(i);
+        values_.push_back(packedAt(base, texts.offsets, i));
+        folded_.push_back(arena_.storeFolded(values_.back()));
+        index_.emplace(values_.back(), code);
+        if (indexed_) trigrams_.add(code, folded_.back());
+    }
+}
+
+void StringDictionary::clear() {
+    sorted_.clear();
+    trigrams_.clear();
+    index_.clear();
+    values_.clear();
+    folded_.clear();
+    arena_.clear();
+}
+
+
+
+//--------------------------------- IdIndex ---------------------------------------
+
+std::uint32_t IdIndex::find(int id) const {
+    if (id >= 0 && static_cast<size_t>(id) < dense_.size()) return dense_[id];
+    if (sparse_.empty()) return npos;
+    auto it = sparse_.find(id);
+    return it == sparse_.end() ? npos : it->second;
+}
+
+bool IdIndex::assign(const std::vector<int>& ids) {
+    clear();
+
+    // Tabelle höchstens so groß, wie set sie wachsen ließe, der Rest in die Hash-Map
+    const size_t limit = std::max<size_t>(1024, 2 * (ids.size() + 1));
+    size_t denseSize = 0;
+    for (int id : ids) {
+        if (id >= 0 && static_cast<size_t>(id) < limit) denseSize = std::max(denseSize, static_cast<size_t>(id) + 1);
+    }
+    dense_.assign(denseSize, npos);
+
+    bool duplicates = false;
+    for (size_t slot = 0; slot < ids.size(); ++slot) {
+        const int id = ids[slot];
+        const std::uint32_t s = static_cast<std::uint32_t>(slot);
+        bool added;
+        if (id >= 0 && static_cast<size_t>(id) < dense_.size()) {
+            added = dense_[id] == npos;
+            if (added) dense_[id] = s;
+        }
+        else {
+            added = sparse_.try_emplace(id, s).second;
+        }
+        if (added) ++count_;
+        else duplicates = true;
+    }
+    return duplicates;
+}
+
+void IdIndex::set(int id, std::uint32_t slot) {
+    if (id >= 0 && static_cast<size_t>(id) >= dense_.size()) {
+        // Tabelle nur vergrößern, wenn sie dadurch nicht überwiegend leer wird
+        size_t limit = std::max<size_t>(1024, 2 * (count_ + 1));
+        if (static_cast<size_t>(id) < limit) {
+            dense_.resize(std::min(limit, std::max<size_t>(static_cast<size_t>(id) + 1, dense_.size() * 2)), npos);
+
+            // Einträge, die jetzt in die Tabelle fallen, aus der Hash-Map übernehmen
+            for (auto it = sparse_.begin(); it != sparse_.end();) {
+                if (it->first >= 0 && static_cast<size_t>(it->first) < dense_.size()) {
+                    dense_[it->first] = it->second;
+                    it = sparse_.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    if (id >= 0 && static_cast<size_t>(id) < dense_.size()) {
+        if (dense_[id] == npos) ++count_;
+        dense_[id] = slot;
+    }
+    else if (sparse_.insert_or_assign(id, slot).second) {
+        ++count_;
+    }
+}
+
+void IdIndex::erase(int id) {
+    if (id >= 0 && static_cast<size_t>(id) < dense_.size()) {
+        if (dense_[id] != npos) --count_;
+        dense_[id] = npos;
+    }
+    else {
+        count_ -= sparse_.erase(id);
+    }
+}
+
+void IdIndex::clear() {
+    dense_.clear();
+    sparse_.clear();
+    count_ = 0;
+}
+
+
+
+//--------------------------------- TrackColumns ---------------------------------------
+
+TrackColumns::TrackColumns(const TrackColumns& other)
+    : ids_(other.ids_), live_(other.live_), deleted_(other.deleted_), layout_(other.layout_),
+      duplicateIds_(other.duplicateIds_),
+      years_(other.years_), durations_(other.durations_),
+      artists_(other.artists_), albums_(other.albums_), genres_(other.genres_),
+      artistDict_(other.artistDict_), albumDict_(other.albumDict_), genreDict_(other.genreDict_),
+      idIndex_(other.idIndex_), indexed_(other.indexed_), titleTrigrams_(other.titleTrigrams_),
+      artistUses_(other.artistUses_), albumUses_(other.albumUses_), genreUses_(other.genreUses_) {
+    // Titel in die eigene Arena übernehmen (die Wörterbücher vergeben beim Kopieren
+    // dieselben Codes in derselben Reihenfolge, die Codespalten passen also weiter)
+    titles_.reserve(other.titles_.size());
+    foldedTitles_.reserve(other.titles_.size());
+    for (std::string_view title : other.titles_) {
+        titles_.push_back(titleArena_.store(title));
+        foldedTitles_.push_back(titleArena_.storeFolded(titles_.back()));
+    }
+}
+
+TrackColumns& TrackColumns::operator=(const TrackColumns& other) {
+    if (this != &other) {
+        TrackColumns copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+void TrackColumns::reserve(std::size_t n) {
+    ids_.reserve(n);
+    live_.reserve(n);
+    years_.reserve(n);
+    durations_.reserve(n);
+    titles_.reserve(n);
+    foldedTitles_.reserve(n);
+    artists_.reserve(n);
+    albums_.reserve(n);
+    genres_.reserve(n);
+}
+
+void TrackColumns::clear() {
+    ++layout_;
+    ids_.clear();
+    live_.clear();
+    deleted_ = 0;
+    duplicateIds_ = false;
+    years_.clear();
+    durations_.clear();
+    titles_.clear();
+    foldedTitles_.clear();
+    artists_.clear();
+    albums_.clear();
+    genres_.clear();
+    artistDict_.clear();
+    albumDict_.clear();
+    genreDict_.clear();
+    titleArena_.clear();
+    idIndex_.clear();
+    titleTrigrams_.clear();
+    artistUses_.clear();
+    albumUses_.clear();
+    genreUses_.clear();
+    titleOrder_.clear();
+    titleMoved_.clear();
+    yearOrder_.clear();
+    yearMoved_.clear();
+    durationOrder_.clear();
+    durationMoved_.clear();
+}
+
+void TrackColumns::assignPacked(std::size_t count, const char* ids, const char* years, const char* durations,
+    const PackedTexts& titles, const char* const (&codes)[3], const PackedTexts (&dicts)[3]) {
+    clear();
+
+    auto copyColumn = [count](auto& column, const char* src) {
+        column.resize(count);
+        if (count > 0) std::memcpy(column.data(), src, count * 4);
+    };
+    copyColumn(ids_, ids);
+    copyColumn(years_, years);
+    copyColumn(durations_, durations);
+    copyColumn(artists_, codes[0]);
+    copyColumn(albums_, codes[1]);
+    copyColumn(genres_, codes[2]);
+    live_.assign(count, 1);
+
+    artistDict_.assignPacked(dicts[0]);
+    albumDict_.assignPacked(dicts[1]);
+    genreDict_.assignPacked(dicts[2]);
+
+    // Titel und ihre Kleinbuchstaben je als ein Block, die Sichten zeigen hinein
+    const std::string_view blob = titleArena_.store(std::string_view(titles.blob, static_cast<size_t>(titles.blobBytes)));
+    const std::string_view folded = titleArena_.storeFolded(blob);
+    titles_.resize(count);
+    foldedTitles_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        titles_[i] = packedAt(blob.data(), titles.offsets, i);
+        foldedTitles_[i] = std::string_view(folded.data() + (titles_[i].data() - blob.data()), titles_[i].size());
+    }
+
+    artistUses_.assign(artistDict_.size(), 0);
+    albumUses_.assign(albumDict_.size(), 0);
+    genreUses_.assign(genreDict_.size(), 0);
+    for (size_t i = 0; i < count; ++i) {
+        ++artistUses_[artists_[i]];
+        ++albumUses_[albums_[i]];
+        ++genreUses_[genres_[i]];
+    }
+
+    duplicateIds_ = idIndex_.assign(ids_);
+    if (indexed_) {
+        for (size_t i = 0; i < count; ++i) titleTrigrams_.add(static_cast<std::uint32_t>(i), foldedTitles_[i]);
+    }
+}
+
+void TrackColumns::setTrigramIndex(bool on) {
+    artistDict_.setTrigramIndex(on);
+    albumDict_.setTrigramIndex(on);
+    genreDict_.setTrigramIndex(on);
+    if (on == indexed_) return;
+    indexed_ = on;
+    titleTrigrams_.clear();
+    if (!on) return;
+    for (size_t i = 0; i < foldedTitles_.size(); ++i) {
+        if (live_[i]) titleTrigrams_.add(static_cast<std::uint32_t>(i), foldedTitles_[i]);
+    }
+}
+
+std::size_t TrackColumns::find(int id) const {
+    std::uint32_t slot = idIndex_.find(id);
+    return slot == IdIndex::npos ? npos : slot;
+}
+
+void TrackColumns::pushSlot_(int id) {
+    if (idIndex_.find(id) == IdIndex::npos) idIndex_.set(id, static_cast<std::uint32_t>(ids_.size()));
+    else duplicateIds_ = true;
+    ids_.push_back(id);
+    live_.push_back(1);
+}
+
+void TrackColumns::pushCoded_(std::string_view artist, std::string_view album, std::string_view genre) {
+    artists_.push_back(artistDict_.intern(artist));
+    albums_.push_back(albumDict_.intern(album));
+    genres_.push_back(genreDict_.intern(genre));
+    countUses_(artists_.size() - 1, +1);
+}
+
+void TrackColumns::countUses_(std::size_t slot, int delta) {
+    auto count = [delta](std::vector<std::uint32_t>& uses, std::uint32_t code) {
+        if (code >= uses.size()) uses.resize(code + 1, 0);
+        uses[code] += delta;
+    };
+    count(artistUses_, artists_[slot]);
+    count(albumUses_, albums_[slot]);
+    count(genreUses_, genres_[slot]);
+}
+
+// Slot-Ordnung nachziehen: geänderte Slots (moved) herausnehmen und zusammen mit den
+// neuen Slots ab order.size() sortiert wieder einmischen. Ein Durchgang über order,
+// sortiert wird nur, was sich geändert hat.
+template<typename Less>
+static void mergeNewSlots(std::vector<std::uint32_t>& order, std::vector<std::uint32_t>& moved,
+                          size_t slotCount, Less less) {
+    const size_t known = order.size();
+    if (known == slotCount && moved.empty()) return;
+    std::vector<char> changed(known, 0);
+    for (std::uint32_t slot : moved) changed[slot] = 1;
+    moved.clear();
+    order.erase(std::remove_if(order.begin(), order.end(), [&](std::uint32_t slot) { return changed[slot]; }),
+                order.end());
+    const size_t done = order.size();
+    for (size_t slot = 0; slot < known; ++slot) {
+        if (changed[slot]) order.push_back(static_cast<std::uint32_t>(slot));
+    }
+    for (size_t slot = known; slot < slotCount; ++slot) order.push_back(static_cast<std::uint32_t>(slot));
+    std::sort(order.begin() + done, order.end(), less);
+    std::inplace_merge(order.begin(), order.begin() + done, order.end(), less);
+}
+
+// Slot einer Ordnung zum Nachziehen vormerken, sein Schlüssel ändert sich gleich. Noch
+// nicht erfasste Slots kommen ohnehin dazu. Wächst der Puffer über die Ordnung hinaus
+// (viele Änderungen ohne Abfrage), wird die Ordnung beim nächsten Aufruf neu sortiert.
+static void markMoved(std::vector<std::uint32_t>& order, std::vector<std::uint32_t>& moved, size_t slot) {
+    if (slot >= order.size()) return;
+    moved.push_back(static_cast<std::uint32_t>(slot));
+    if (moved.size() > order.size()) {
+        order.clear();
+        moved.clear();
+    }
+}
+
+// Vergleich für Slot-Ordnungen über eine Zahlenspalte, bei gleichem Wert nach Slot
+static auto slotsByValue(const std::vector<int>& column) {
+    return [&column](std::uint32_t a, std::uint32_t b) {
+        return column[a] != column[b] ? column[a] < column[b] : a < b;
+    };
+}
+
+auto TrackColumns::titleLess_() const {
+    return [this](std::uint32_t a, std::uint32_t b) {
+        return foldedTitles_[a] != foldedTitles_[b] ? foldedTitles_[a] < foldedTitles_[b] : a < b;
+    };
+}
+
+const std::vector<std::uint32_t>& TrackColumns::titleOrder() const {
+    std::lock_guard<std::mutex> lock(orderMutex_.m);
+    mergeNewSlots(titleOrder_, titleMoved_, foldedTitles_.size(), titleLess_());
+    return titleOrder_;
+}
+
+const std::vector<std::uint32_t>& TrackColumns::yearOrder() const {
+    std::lock_guard<std::mutex> lock(orderMutex_.m);
+    mergeNewSlots(yearOrder_, yearMoved_, years_.size(), slotsByValue(years_));
+    return yearOrder_;
+}
+
+const std::vector<std::uint32_t>& TrackColumns::durationOrder() const {
+    std::lock_guard<std::mutex> lock(orderMutex_.m);
+    mergeNewSlots(durationOrder_, durationMoved_, durations_.size(), slotsByValue(durations_));
+    return durationOrder_;
+}
+
+void TrackColumns::push_back(const MusicTrack& t) {
+    pushSlot_(t.id);
+    years_.push_back(t.year);
+    durations_.push_back(t.durationSec);
+    titles_.push_back(titleArena_.store(t.title));
+    foldedTitles_.push_back(titleArena_.storeFolded(titles_.back()));
+    if (indexed_) titleTrigrams_.add(static_cast<std::uint32_t>(ids_.size() - 1), foldedTitles_.back());
+    pushCoded_(t.artist, t.album, t.genre);
+}
+
+void TrackColumns::push_back(const MusicTrackView& t) {
+    pushSlot_(t.id);
+    years_.push_back(t.year);
+    durations_.push_back(t.durationSec);
+    titles_.push_back(titleArena_.store(t.title));
+    foldedTitles_.push_back(titleArena_.storeFolded(titles_.back()));
+    if (indexed_) titleTrigrams_.add(static_cast<std::uint32_t>(ids_.size() - 1), foldedTitles_.back());
+    pushCoded_(t.artist, t.album, t.genre);
+}
+
+void TrackColumns::assign(std::size_t slot, const MusicTrack& t) {
+    if (ids_[slot] != t.id) {
+        if (idIndex_.find(ids_[slot]) == slot) idIndex_.erase(ids_[slot]);
+        if (idIndex_.find(t.id) == IdIndex::npos) idIndex_.set(t.id, static_cast<std::uint32_t>(slot));
+    }
+    ids_[slot] = t.id;
+
+    // Sortierte Slot-Ordnungen bei geändertem Wert nur vormerken, nachgezogen wird beim
+    // nächsten Aufruf von titleOrder(), yearOrder() bzw. durationOrder()
+    if (years_[slot] != t.year) {
+        markMoved(yearOrder_, yearMoved_, slot);
+        years_[slot] = t.year;
+    }
+    if (durations_[slot] != t.durationSec) {
+        markMoved(durationOrder_, durationMoved_, slot);
+        durations_[slot] = t.durationSec;
+    }
+    if (titles_[slot] != t.title) {
+        if (indexed_) titleTrigrams_.remove(static_cast<std::uint32_t>(slot), foldedTitles_[slot]);
+        markMoved(titleOrder_, titleMoved_, slot);
+        titles_[slot] = titleArena_.store(t.title);
+        foldedTitles_[slot] = titleArena_.storeFolded(titles_[slot]);
+        if (indexed_) titleTrigrams_.add(static_cast<std::uint32_t>(slot), foldedTitles_[slot]);
+    }
+    if (live_[slot]) countUses_(slot, -1);
+    artists_[slot] = artistDict_.intern(t.artist);
+    albums_[slot] = albumDict_.intern(t.album);
+    genres_[slot] = genreDict_.intern(t.genre);
+    if (live_[slot]) countUses_(slot, +1);
+}
+
+void TrackColumns::erase(std::size_t slot) {
+    if (!live_[slot]) return;
+    live_[slot] = 0;
+    ++deleted_;
+    countUses_(slot, -1);
+
+    const int id = ids_[slot];
+    if (idIndex_.find(id) != slot) return;
+    idIndex_.erase(id);
+
+    // Doppelte ID: der nächste lebende Slot mit derselben ID übernimmt
+    if (duplicateIds_) {
+        for (size_t i = slot + 1; i < ids_.size(); ++i) {
+            if (live_[i] && ids_[i] == id) {
+                idIndex_.set(id, static_cast<std::uint32_t>(i));
+                break;
+            }
+        }
+    }
+}
+
+void TrackColumns::compact() {
+    if (deleted_ == 0) return;
+    ++layout_;
+
+    size_t out = 0;
+    for (size_t i = 0; i < ids_.size(); ++i) {
+        if (!live_[i]) continue;
+        ids_[out] = ids_[i];
+        years_[out] = years_[i];
+        durations_[out] = durations_[i];
+        titles_[out] = titles_[i];
+        foldedTitles_[out] = foldedTitles_[i];
+        artists_[out] = artists_[i];
+        albums_[out] = albums_[i];
+        genres_[out] = genres_[i];
+        ++out;
+    }
+    ids_.resize(out);
+    years_.resize(out);
+    durations_.resize(out);
+    titles_.resize(out);
+    foldedTitles_.resize(out);
+    artists_.resize(out);
+    albums_.resize(out);
+    genres_.resize(out);
+    live_.assign(out, 1);
+    deleted_ = 0;
+    titleOrder_.clear();                            // Ordnungen werden beim nächsten Aufruf neu sortiert
+    titleMoved_.clear();
+    yearOrder_.clear();
+    yearMoved_.clear();
+    durationOrder_.clear();
+    durationMoved_.clear();
+
+    // Slots haben sich verschoben: Index neu aufbauen
+    idIndex_.clear();
+    duplicateIds_ = false;
+    for (size_t i = 0; i < ids_.size(); ++i) {
+        if (idIndex_.find(ids_[i]) == IdIndex::npos) idIndex_.set(ids_[i], static_cast<std::uint32_t>(i));
+        else duplicateIds_ = true;
+    }
+    if (indexed_) {
+        titleTrigrams_.clear();
+        for (size_t i = 0; i < foldedTitles_.size(); ++i) {
+            titleTrigrams_.add(static_cast<std::uint32_t>(i), foldedTitles_[i]);
+        }
+    }
+}
+
+MusicTrack TrackColumns::track(std::size_t slot) const {
+    MusicTrack t;
+    t.id = ids_[slot];
+    t.title.assign(titles_[slot]);
+    t.artist.assign(artistDict_[artists_[slot]]);
+    t.album.assign(albumDict_[albums_[slot]]);
+    t.year = years_[slot];
+    t.genre.assign(genreDict_[genres_[slot]]);
+    t.durationSec = durations_[slot];
+    return t;
+}
+
+MusicTrackView TrackColumns::view(std::size_t slot) const {
+    MusicTrackView v;
+    v.id = ids_[slot];
+    v.title = titles_[slot];
+    v.artist = artistDict_[artists_[slot]];
+    v.album = albumDict_[albums_[slot]];
+    v.year = years_[slot];
+    v.genre = genreDict_[genres_[slot]];
+    v.durationSec = durations_[slot];
+    return v;
+}
+
+
+
+//--------------------------------- TrackList ---------------------------------------
+
+TrackList::TrackList(const TrackColumns& cols) : cols_(&cols) {
+    // Ohne Grabsteine ist Position = Slot, sonst einmal die lebenden Slots sammeln
+    if (cols.deletedCount() == 0) return;
+    liveSlots_.reserve(cols.size());
+    for (size_t i = 0; i < cols.slotCount(); ++i) {
+        if (cols.live(i)) liveSlots_.push_back(static_cast<std::uint32_t>(i));
+    }
+}
+
+
+
+//--------------------------------- MusicTrackView / MappedLibrary ---------------------------------------
+
+MusicTrack MusicTrackView::toTrack() const {                                //Sicht in eigenen Track kopieren
+    MusicTrack t;
+    t.id = id;
+    t.title.assign(title);
+    t.artist.assign(artist);
+    t.album.assign(album);
+    t.year = year;
+    t.genre.assign(genre);
+    t.durationSec = durationSec;
+    return t;
+}
+
+bool MappedLibrary::open(const std::string& snapshotPath) {                 //Snapshot einblenden
+    close();
+
+    MappedFile file(snapshotPath);
+    if (!file.isOpen()) return false;
+
+    // Nur Kopf und Größen prüfen, damit das Öffnen sofort geht;
+    // die Offsets werden beim Zugriff einzeln geprüft
+    SnapshotLayout l;
+    if (!readSnapshotLayout(file.data(), file.size(), l)) return false;
+
+    file_ = std::move(file);
+    const char* d = file_.data();
+    count_ = static_cast<std::size_t>(l.count);
+    ids_ = d + l.ids;
+    years_ = d + l.years;
+    durations_ = d + l.durations;
+    for (int c = 0; c < 4; ++c) {
+        offsets_[c] = d + l.offsets[c];
+        blobs_[c] = d + l.blobs[c];
+        blobBytes_[c] = l.blobBytes[c];
+        entries_[c] = l.entries[c];
+    }
+    for (int c = 0; c < 3; ++c) codes_[c] = l.version >= 2 ? d + l.codes[c] : nullptr;
+    idsSorted_ = (l.flags & kSnapshotIdsSorted) != 0;
+    return true;
+}
+
+void MappedLibrary::close() {
+    file_.close();
+    count_ = 0;
+    idsSorted_ = false;
+}
+
+int MappedLibrary::idAt_(std::size_t index) const {
+    return readRaw<std::int32_t>(ids_ + index * 4);
+}
+
+std::string_view MappedLibrary::text_(int column, std::size_t index) const {
+    // Ab Version 2 steht bei artist/album/genre der Code, der Text im Wörterbuch
+    if (column > 0 && codes_[column - 1]) {
+        index = readRaw<std::uint32_t>(codes_[column - 1] + index * 4);
+    }
+    if (index >= entries_[column]) return {};                    // beschädigter Code
+    std::uint64_t from = readRaw<std::uint64_t>(offsets_[column] + index * 8);
+    std::uint64_t to = readRaw<std::uint64_t>(offsets_[column] + (index + 1) * 8);
+    if (from > to || to > blobBytes_[column]) return {};          // beschädigter Eintrag
+    return { blobs_[column] + from, static_cast<std::size_t>(to - from) };
+}
+
+MusicTrackView MappedLibrary::at(std::size_t index) const {                 //Track an Position index
+    MusicTrackView v;
+    v.id = idAt_(index);
+    v.title = text_(0, index);
+    v.artist = text_(1, index);
+    v.album = text_(2, index);
+    v.year = readRaw<std::int32_t>(years_ + index * 4);
+    v.genre = text_(3, index);
+    v.durationSec = readRaw<std::int32_t>(durations_ + index * 4);
+    return v;
+}
+
+std::optional<MusicTrackView> MappedLibrary::findById(int id) const {       //Track suchen nach ID
+    if (idsSorted_) {
+        // ids aufsteigend: binäre Suche direkt auf der eingeblendeten Spalte
+        std::size_t lo = 0, hi = count_;
+        while (lo < hi) {
+            std::size_t mid = lo + (hi - lo) / 2;
+            if (idAt_(mid) < id) lo = mid + 1;
+            else hi = mid;
+        }
+        if (lo < count_ && idAt_(lo) == id) return at(lo);
+        return std::nullopt;
+    }
+
+    for (std::size_t i = 0; i < count_; ++i) {
+        if (idAt_(i) == id) return at(i);
+    }
+    return std::nullopt;
+}
+
+std::vector<MusicTrackView> MappedLibrary::search(const std::string& query, Field by) const {    //Track suchen nach string
+    std::vector<MusicTrackView> results;
+    const std::string folded = foldCase(query);
+    const std::optional<int> year = yearQuery(query);
+
+    for (std::size_t i = 0; i < count_; ++i) {
+        MusicTrackView v = at(i);
+        if (matchesQuery(v, folded, year, by)) results.push_back(v);
+    }
+
+    return results;
+}
+
+
+
+//--------------------------------- AutoSaver ---------------------------------------
+
+AutoSaver::AutoSaver(MusicLibrary& lib, std::string csvPath, std::chrono::milliseconds delay)
+    : lib_(lib), path_(std::move(csvPath)), delay_(delay) {
+    thread_ = std::thread(&AutoSaver::run_, this);
+}
+
+AutoSaver::~AutoSaver() {
+    stop();
+}
+
+void AutoSaver::markDirty() {                                           //Änderung melden
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!dirty_) {
+        dirty_ = true;
+        dirtySince_ = std::chrono::steady_clock::now();
+    }
+    cv_.notify_one();
+}
+
+void AutoSaver::stop(bool savePending) {                                //Thread beenden
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) return;
+        stopping_ = true;
+        if (!savePending) dirty_ = false;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) thread_.join();
+}
+
+AutoSaveStatus AutoSaver::status() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return status_;
+}
+
+void AutoSaver::run_() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return dirty_ || stopping_; });
+        if (!dirty_) break;
+
+        // Änderungen innerhalb von delay_ nach der ersten werden zu einer Speicherung zusammengefasst
+        if (!stopping_) {
+            cv_.wait_until(lock, dirtySince_ + delay_, [this] { return stopping_; });
+        }
+        if (!dirty_) continue;                  // stop(false) hat offene Änderungen verworfen
+
+        dirty_ = false;
+        status_.saving = true;
+        lock.unlock();
+
+        auto started = std::chrono::steady_clock::now();
+        bool ok = lib_.checkpointCopy(path_);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+        lock.lock();
+        status_.saving = false;
+        status_.lastOk = ok;
+        status_.lastSaveSeconds = seconds;
+        status_.lastSaveTime = std::chrono::system_clock::now();
+        if (ok) ++status_.saves;
+        else ++status_.failures;
     }
-    nextId_ = maxId + 1;
 }
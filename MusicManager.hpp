@@ -1,6 +1,6 @@
 /**
 * =============================================================================
-*  MUSIK-BIBLIOTHEK  HEADER - MUSICMANAGER.HPP
+*  MUSIK-BIBLIOTHEK – HEADER - MUSICMANAGER.HPP
 * =============================================================================
 *  Datei:        MusicLibrary.hpp
 *  Projekt:      Einfache Musik-Bibliothek (CSV-basiert)
@@ -10,9 +10,9 @@
 *  Datum:        2025-12-22
 * 
 *  Hinweis / Disclaimer:
-*  Fr die Gestaltung, Optimierung, Strukturierung sowie Untersttzung bei der
+*  Für die Gestaltung, Optimierung, Strukturierung sowie Unterstützung bei der
 *  Fehlersuche wurde ChatGPT verwendet. Der Code wurde jedoch
-*  eigenstndig berprft und angepasst, um den Projektanforderungen zu gengen.
+*  eigenständig überprüft und angepasst, um den Projektanforderungen zu genügen.
 * 
 * =============================================================================
 */
@@ -22,8 +22,20 @@
 // Verhindert dass HEader mehrfach eingebunden wird
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <optional>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <cstdio>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
 
 
 //Musiktitel mit typischen Feldern.
@@ -31,11 +43,386 @@
 struct MusicTrack {
     int id{ 0 };                // Track ID
     std::string title;          // Titel 
-    std::string artist;         // Knstler
+    std::string artist;         // Künstler
     std::string album;          // Album
     int year{ 0 };              // Erscheinungsjahr 
     std::string genre;          // Genre 
-    int durationSec{ 0 };       // Lnge in sek
+    int durationSec{ 0 };       // Länge in sek
+};
+
+// Leichtgewichtige Sicht auf einen Track, die Texte zeigen in fremden Speicher
+// (z.B. eine eingeblendete Datei) und sind nur so lange gültig wie dieser.
+
+struct MusicTrackView {
+    int id{ 0 };
+    std::string_view title;
+    std::string_view artist;
+    std::string_view album;
+    int year{ 0 };
+    std::string_view genre;
+    int durationSec{ 0 };
+
+    // Kopie als eigenständiger MusicTrack
+    MusicTrack toTrack() const;
+};
+
+
+// Speicher für viele kleine Texte: die Bytes werden hintereinander in große Blöcke
+// gelegt statt einzeln auf dem Heap. clear() setzt nur die Schreibposition zurück,
+// die Blöcke werden beim nächsten Laden wiederverwendet. Abgelegte Texte bleiben bis
+// clear() gültig (auch nach einem Move), einzeln freigegeben wird nichts.
+
+class StringArena {
+public:
+    StringArena() = default;
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+    StringArena(StringArena&&) = default;
+    StringArena& operator=(StringArena&&) = default;
+
+    // s in die Arena kopieren, liefert die Sicht auf die Kopie
+    std::string_view store(std::string_view s);
+
+    // Wie store, aber die Kopie in Kleinbuchstaben (ASCII); ohne Großbuchstaben
+    // wird nichts kopiert und s selbst zurückgegeben
+    std::string_view storeFolded(std::string_view s);
+
+    void clear();
+
+    // Belegte bzw. insgesamt angeforderte Bytes
+    std::size_t bytesUsed() const;
+    std::size_t bytesReserved() const;
+
+private:
+    static constexpr std::size_t kChunkBytes = 256 * 1024;
+
+    // n Bytes (n > 0) im aktuellen oder nächsten Block belegen
+    char* allocate_(std::size_t n);
+
+    struct Chunk {
+        std::unique_ptr<char[]> data;
+        std::size_t size{ 0 };
+    };
+
+    std::vector<Chunk> chunks_;
+    std::size_t current_{ 0 };          // Block, in den gerade geschrieben wird
+    std::size_t used_{ 0 };             // belegte Bytes im aktuellen Block
+};
+
+
+// Mutex, der beim Verschieben nicht mitwandert (jedes Objekt hat seinen eigenen)
+
+struct OwnMutex {
+    std::mutex m;
+    OwnMutex() = default;
+    OwnMutex(OwnMutex&&) noexcept {}
+    OwnMutex& operator=(OwnMutex&&) noexcept { return *this; }
+};
+
+
+// Texte am Stück (z.B. direkt aus einem eingeblendeten Snapshot): Eintrag i liegt in
+// blob[offsets[i] .. offsets[i + 1]), offsets sind count + 1 uint64 (beliebig ausgerichtet)
+
+struct PackedTexts {
+    const char* blob{ nullptr };
+    std::uint64_t blobBytes{ 0 };
+    const char* offsets{ nullptr };
+    std::size_t count{ 0 };
+};
+
+
+// Trigramm-Index: zu jeder Folge von drei Bytes (in Kleinbuchstaben) die aufsteigend
+// sortierte Liste der Einträge (Slots bzw. Codes), deren Text sie enthält. Liefert
+// Kandidaten für die Teilstring-Suche, die danach noch exakt geprüft werden.
+
+class TrigramIndex {
+public:
+    // Alle Trigramme von folded für id eintragen bzw. austragen. Was nicht hinten an
+    // eine Liste passt, wird nur vorgemerkt und in einem Durchgang je Liste
+    // eingearbeitet, sobald der Puffer so groß wie die Liste ist.
+    void add(std::uint32_t id, std::string_view folded);
+    void remove(std::uint32_t id, std::string_view folded);
+    void clear() { postings_.clear(); }
+
+    // Kandidaten für den Suchbegriff folded (Schnitt der Listen, aufsteigend).
+    // false, wenn folded kürzer als drei Bytes ist und der Index nicht hilft.
+    // Ändert nichts, darf also gleichzeitig mit anderen lesenden Aufrufen laufen.
+    bool candidates(std::string_view folded, std::vector<std::uint32_t>& out) const;
+
+private:
+    struct Posting {
+        std::vector<std::uint32_t> ids;             // aufsteigend
+        std::vector<std::uint64_t> pending;         // id << 1, Bit 0 = eintragen; in Aufrufreihenfolge
+    };
+
+    // Liste mit eingearbeiteten vorgemerkten Änderungen
+    static std::vector<std::uint32_t> settled_(const Posting& p);
+    void mark_(std::uint32_t gram, Posting& p, std::uint32_t id, bool add);
+
+    std::unordered_map<std::uint32_t, Posting> postings_;
+};
+
+
+// Wörterbuch für oft wiederholte Texte (Interpret, Album, Genre): jeder Text wird
+// nur einmal gespeichert, Tracks halten nur den 32-Bit-Code. Codes bleiben bis
+// clear() gültig, auch wenn kein Track sie mehr benutzt.
+
+class StringDictionary {
+public:
+    StringDictionary() = default;
+    StringDictionary(const StringDictionary& other);
+    StringDictionary& operator=(const StringDictionary& other);
+    StringDictionary(StringDictionary&&) = default;
+    StringDictionary& operator=(StringDictionary&&) = default;
+
+    // Code für s, neuer Eintrag wenn s noch nicht vorkommt
+    std::uint32_t intern(std::string_view s);
+
+    std::string_view operator[](std::uint32_t code) const { return values_[code]; }
+
+    // Eintrag in Kleinbuchstaben (für die Suche)
+    std::string_view folded(std::uint32_t code) const { return folded_[code]; }
+
+    std::size_t size() const { return values_.size(); }
+    void clear();
+
+    // Inhalt durch gepackte Einträge ersetzen (Code i = Eintrag i), die Texte werden
+    // am Stück in die Arena kopiert
+    void assignPacked(const PackedTexts& texts);
+
+    // Optionaler Trigramm-Index über die Einträge
+    void setTrigramIndex(bool on);
+    bool trigramIndexed() const { return indexed_; }
+    const TrigramIndex& trigrams() const { return trigrams_; }
+
+    // Alle Codes, aufsteigend nach gefaltetem Eintrag (für Präfix-Suche). Wird beim
+    // Aufruf nachgezogen: neue Codes werden sortiert eingemischt. Das Nachziehen läuft
+    // unter sortMutex_, mehrere lesende Threads dürfen also gleichzeitig fragen.
+    const std::vector<std::uint32_t>& sortedCodes() const;
+
+private:
+    mutable OwnMutex sortMutex_;
+    mutable std::vector<std::uint32_t> sorted_;
+    bool indexed_{ false };
+    TrigramIndex trigrams_;
+    StringArena arena_;
+    std::vector<std::string_view> values_;                  // Sichten in arena_
+    std::vector<std::string_view> folded_;                  // dieselben Einträge in Kleinbuchstaben
+    std::unordered_map<std::string_view, std::uint32_t> index_;
+};
+
+
+// Zuordnung ID -> Slot. IDs aus nextId_ sind fortlaufend und landen in einer direkt
+// adressierten Tabelle, vereinzelte große oder negative IDs (z.B. aus importierten
+// CSV-Dateien) in einer Hash-Map.
+
+class IdIndex {
+public:
+    static constexpr std::uint32_t npos = UINT32_MAX;
+
+    // Slot zu id, npos wenn nicht vorhanden
+    std::uint32_t find(int id) const;
+
+    // Index für ids[0..n-1] (Slot = Position) in einem Durchgang aufbauen, bei doppelten
+    // IDs gilt der erste Slot. Liefert true, wenn eine ID mehrfach vorkommt.
+    bool assign(const std::vector<int>& ids);
+
+    // id auf slot setzen (vorhandenen Eintrag überschreiben)
+    void set(int id, std::uint32_t slot);
+
+    void erase(int id);
+    void clear();
+
+private:
+    std::vector<std::uint32_t> dense_;                      // Index = ID
+    std::unordered_map<int, std::uint32_t> sparse_;         // IDs außerhalb von dense_
+    std::size_t count_{ 0 };                                // Einträge insgesamt
+};
+
+
+// Spaltenweise Ablage der Tracks (struct of arrays). Zahlen und Texte liegen jeweils
+// in eigenen zusammenhängenden Arrays, gleiche Position (Slot) = gleicher Track.
+// Ein Filter über year oder durationSec liest so nur die benötigte Spalte.
+// Titel liegen in einer StringArena, alte Titel geänderter Tracks bleiben dort bis clear().
+// Gelöschte Tracks bleiben als Grabstein (tombstone) in ihrem Slot stehen, bis compact()
+// sie entfernt; bis dahin behalten alle anderen Tracks ihren Slot und ihre Reihenfolge.
+
+class TrackColumns {
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    TrackColumns() = default;
+    TrackColumns(const TrackColumns& other);
+    TrackColumns& operator=(const TrackColumns& other);
+    TrackColumns(TrackColumns&&) = default;
+    TrackColumns& operator=(TrackColumns&&) = default;
+
+    // Anzahl lebender Tracks
+    std::size_t size() const { return ids_.size() - deleted_; }
+    bool empty() const { return size() == 0; }
+
+    // Anzahl Slots inkl. Grabsteine, Slots sind 0 .. slotCount()-1
+    std::size_t slotCount() const { return ids_.size(); }
+    std::size_t deletedCount() const { return deleted_; }
+
+    // Zähler, der sich bei jeder Verschiebung von Slots ändert (compact, clear)
+    std::uint64_t layout() const { return layout_; }
+    bool live(std::size_t slot) const { return live_[slot] != 0; }
+
+    void reserve(std::size_t n);
+    std::size_t capacity() const { return ids_.capacity(); }
+    void clear();
+
+    void push_back(const MusicTrack& t);
+    void push_back(const MusicTrackView& t);
+
+    // Inhalt auf einmal aus fertigen Spalten ersetzen (für loadSnapshot): Zahlen als
+    // count int32, Codes als count uint32 (kleiner als die Wörterbuchgröße). Texte und
+    // Wörterbücher werden am Stück kopiert, der ID-Index in einem Durchgang gebaut.
+    void assignPacked(std::size_t count, const char* ids, const char* years, const char* durations,
+        const PackedTexts& titles, const char* const (&codes)[3], const PackedTexts (&dicts)[3]);
+
+    // Track an Position slot überschreiben
+    void assign(std::size_t slot, const MusicTrack& t);
+
+    // Track an Position slot als gelöscht markieren (O(1), Slots bleiben gleich)
+    void erase(std::size_t slot);
+
+    // Grabsteine entfernen, spätere Tracks rücken auf (Reihenfolge bleibt)
+    void compact();
+
+    // Slot des Tracks mit dieser ID (bei doppelten IDs der erste lebende), npos wenn nicht vorhanden
+    std::size_t find(int id) const;
+
+    // Track an Position slot als eigene Kopie bzw. als Sicht auf die Spalten
+    MusicTrack track(std::size_t slot) const;
+    MusicTrackView view(std::size_t slot) const;
+
+    // Zahlenspalten direkt (für Filter und Aggregationen)
+    const std::vector<int>& ids() const { return ids_; }
+    const std::vector<int>& years() const { return years_; }
+    const std::vector<int>& durations() const { return durations_; }
+
+    // Titel in Kleinbuchstaben (Schattenspalte für die Suche)
+    std::string_view foldedTitle(std::size_t slot) const { return foldedTitles_[slot]; }
+
+    // Optionaler Trigramm-Index über Titel (Slots) und die drei Wörterbücher (Codes).
+    // Gelöschte Slots bleiben bis compact() in den Listen, die Suche prüft live().
+    void setTrigramIndex(bool on);
+    bool trigramIndexed() const { return indexed_; }
+    const TrigramIndex& titleTrigrams() const { return titleTrigrams_; }
+
+    // Alle Slots, aufsteigend nach gefaltetem Titel (für Präfix-Suche, enthält auch
+    // Grabsteine). Neue und geänderte Slots werden beim Aufruf unter orderMutex_
+    // nachgezogen, gleichzeitige Leser sind erlaubt.
+    const std::vector<std::uint32_t>& titleOrder() const;
+
+    // Alle Slots, aufsteigend nach Jahr bzw. Dauer, bei gleichem Wert nach Slot
+    // (für Bereichsabfragen, enthält auch Grabsteine). Wie titleOrder nachgezogen:
+    // geänderte Werte merkt assign nur vor, der nächste Aufruf sortiert sie unter
+    // orderMutex_ wieder ein. Gleichzeitige Leser sind erlaubt, nur Ändern
+    // währenddessen nicht. Kopien beginnen ohne Ordnungen.
+    const std::vector<std::uint32_t>& yearOrder() const;
+    const std::vector<std::uint32_t>& durationOrder() const;
+
+    // Anzahl lebender Tracks je Code (für Gewichtung), wird bei jeder Änderung mitgeführt
+    const std::vector<std::uint32_t>& artistUses() const { return artistUses_; }
+    const std::vector<std::uint32_t>& albumUses() const { return albumUses_; }
+    const std::vector<std::uint32_t>& genreUses() const { return genreUses_; }
+
+    // Codespalten und Wörterbücher für Interpret, Album und Genre
+    const std::vector<std::uint32_t>& artistCodes() const { return artists_; }
+    const std::vector<std::uint32_t>& albumCodes() const { return albums_; }
+    const std::vector<std::uint32_t>& genreCodes() const { return genres_; }
+    const StringDictionary& artistDict() const { return artistDict_; }
+    const StringDictionary& albumDict() const { return albumDict_; }
+    const StringDictionary& genreDict() const { return genreDict_; }
+
+private:
+    void pushCoded_(std::string_view artist, std::string_view album, std::string_view genre);
+
+    void pushSlot_(int id);
+
+    // Vergleich für titleOrder_: gefalteter Titel, bei Gleichstand Slot
+    auto titleLess_() const;
+
+    // Nutzungszähler der drei Codes eines Slots um delta ändern
+    void countUses_(std::size_t slot, int delta);
+
+    std::vector<int> ids_;
+    std::vector<char> live_;                        // 0 = Grabstein
+    std::size_t deleted_{ 0 };
+    std::uint64_t layout_{ 0 };
+    bool duplicateIds_{ false };                    // eine ID kam mehrfach vor (z.B. importierte CSV)
+    std::vector<int> years_;
+    std::vector<int> durations_;
+    std::vector<std::string_view> titles_;          // Sichten in titleArena_
+    std::vector<std::string_view> foldedTitles_;    // Kleinbuchstaben, ebenfalls in titleArena_
+    std::vector<std::uint32_t> artists_;
+    std::vector<std::uint32_t> albums_;
+    std::vector<std::uint32_t> genres_;
+    StringDictionary artistDict_;
+    StringDictionary albumDict_;
+    StringDictionary genreDict_;
+    StringArena titleArena_;
+    IdIndex idIndex_;
+    bool indexed_{ false };
+    TrigramIndex titleTrigrams_;
+    std::vector<std::uint32_t> artistUses_;
+    std::vector<std::uint32_t> albumUses_;
+    std::vector<std::uint32_t> genreUses_;
+    mutable OwnMutex orderMutex_;                   // schützt das Nachziehen der Ordnungen
+    mutable std::vector<std::uint32_t> titleOrder_;
+    mutable std::vector<std::uint32_t> yearOrder_;
+    mutable std::vector<std::uint32_t> durationOrder_;
+    mutable std::vector<std::uint32_t> titleMoved_;    // Slots mit geändertem Wert, noch einzusortieren
+    mutable std::vector<std::uint32_t> yearMoved_;
+    mutable std::vector<std::uint32_t> durationMoved_;
+};
+
+
+// Nur-Lese-Sicht auf alle Tracks einer Bib (Rückgabe von listAll). Die Elemente
+// werden beim Zugriff aus den Spalten als MusicTrack zusammengesetzt, Grabsteine
+// werden übersprungen.
+
+class TrackList {
+public:
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = MusicTrack;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = MusicTrack;
+
+        const_iterator(const TrackColumns* cols, std::size_t slot) : cols_(cols), slot_(slot) { skipDeleted_(); }
+        MusicTrack operator*() const { return cols_->track(slot_); }
+        const_iterator& operator++() { ++slot_; skipDeleted_(); return *this; }
+        const_iterator operator++(int) { const_iterator old = *this; ++*this; return old; }
+        bool operator==(const const_iterator& o) const { return slot_ == o.slot_; }
+        bool operator!=(const const_iterator& o) const { return slot_ != o.slot_; }
+
+    private:
+        void skipDeleted_() {
+            while (slot_ < cols_->slotCount() && !cols_->live(slot_)) ++slot_;
+        }
+
+        const TrackColumns* cols_;
+        std::size_t slot_;
+    };
+
+    explicit TrackList(const TrackColumns& cols);
+
+    std::size_t size() const { return cols_->size(); }
+    bool empty() const { return cols_->empty(); }
+    MusicTrack operator[](std::size_t i) const { return cols_->track(liveSlots_.empty() ? i : liveSlots_[i]); }
+
+    const_iterator begin() const { return const_iterator(cols_, 0); }
+    const_iterator end() const { return const_iterator(cols_, cols_->slotCount()); }
+
+private:
+    const TrackColumns* cols_;
+    std::vector<std::uint32_t> liveSlots_;          // nur bei Grabsteinen: i-ter Track -> Slot
 };
 
 // Enum mit klar abgegrenzten Werten ("scoped enum").
@@ -43,65 +430,578 @@ struct MusicTrack {
 enum class Field { Any, Title, Artist, Album, Genre, Year };
 
 
+// Zahlenspalte für Bereichsabfragen (Jahr bzw. Dauer in Sekunden)
+
+enum class RangeField { Year, Duration };
+
+
+// Fehlerarten beim Einlesen einer CSV-Zeile
+
+enum class CsvError { None, FieldCount, InvalidNumber, OutOfRange };
+
+
+// Fehlerbeschreibung für eine CSV-Zeile (ohne Exceptions)
+
+struct CsvRowError {
+    CsvError code{ CsvError::None };
+    int column{ -1 };           // betroffene Spalte 0..6 (id..durationSec), bei FieldCount die erste fehlende/überzählige
+    std::size_t offset{ 0 };    // Byte-Position des Fehlers in der Zeile
+};
+
+
+// Verworfene Zeile beim Laden
+
+struct CsvRejection {
+    std::size_t line{ 0 };      // Zeilennummer in der Datei (Kopfzeile = 1)
+    CsvRowError error;
+};
+
+
+// Kennzahlen des letzten Ladevorgangs (Durchsatz in MB/s und Zeilen/s)
+
+struct LoadStats {
+    std::size_t bytes{ 0 };     // gelesene Bytes
+    std::size_t rows{ 0 };      // übernommene Zeilen
+    std::size_t rejected{ 0 };  // verworfene Zeilen (Leerzeilen zählen nicht)
+    double seconds{ 0.0 };      // Dauer in Sekunden
+
+    double mbPerSec() const { return seconds > 0.0 ? bytes / (1024.0 * 1024.0) / seconds : 0.0; }
+    double rowsPerSec() const { return seconds > 0.0 ? rows / seconds : 0.0; }
+};
+
+
+// Fortsetzungspunkt für seitenweises Auflisten/Suchen. Ein Standard-Token beginnt
+// am Anfang. Einfügen und Ändern lassen Tokens gültig. Verdichten (compact(), auch
+// automatisch aus deleteTrack, siehe setCompactionRatio), clear() oder ein Neuladen
+// verschieben die Slots; ältere Tokens werden dann über layout erkannt und abgelehnt.
+
+struct PageToken {
+    std::size_t slot{ 0 };          // erster Slot der nächsten Seite
+    std::uint64_t layout{ 0 };      // Slot-Anordnung, zu der slot gehört
+};
+
+
+// Vorschlag aus suggest: Wert und Anzahl Tracks mit diesem Wert
+
+struct Suggestion {
+    std::string text;
+    std::size_t count{ 0 };
+};
+
+
+// Zusammengesetzte Abfrage als Baum. Blätter prüfen ein Feld (Teilstring bzw. Gleichheit
+// ohne Groß/Klein, Zahlenbereich für Jahr/Dauer), innere Knoten verknüpfen mit AND, OR
+// und NOT. Aufbau über die Fabriken und Operatoren oder aus Text mit parse, z.B.
+//   artist:queen AND year >= 2000 AND (genre = Pop OR NOT duration < 180)
+
+class Query {
+public:
+    enum class Kind { Contains, Equals, Range, And, Or, Not };
+
+    // Blätter (Contains auf Year prüft wie search auf gleiches Jahr)
+    static Query contains(Field by, std::string text);
+    static Query equals(Field by, std::string text);
+    static Query range(RangeField by, int lo, int hi);              // lo <= Wert <= hi
+
+    // Verknüpfungen
+    static Query allOf(std::vector<Query> parts);
+    static Query anyOf(std::vector<Query> parts);
+    static Query negate(Query part);
+
+    // Text einlesen. Syntax: Begriffe verknüpft mit AND/&&, OR/||, NOT/!, Klammern.
+    // Ein Begriff ist feld:text (enthält), feld = text, feld != text, bei year und
+    // duration auch <, <=, >, >= mit Zahl, oder nur text (enthält, alle Felder).
+    // Texte mit Leerzeichen in "...". Bei Fehlern nullopt und (optional) eine Meldung.
+    static std::optional<Query> parse(std::string_view text, std::string* error = nullptr);
+
+    Kind kind() const { return kind_; }
+    Field field() const { return field_; }
+    RangeField rangeField() const { return rangeField_; }
+    const std::string& text() const { return text_; }
+    int lo() const { return lo_; }
+    int hi() const { return hi_; }
+    const std::vector<Query>& parts() const { return parts_; }
+
+private:
+    Query() = default;
+
+    Kind kind_{ Kind::And };
+    Field field_{ Field::Any };
+    RangeField rangeField_{ RangeField::Year };
+    std::string text_;
+    int lo_{ 0 };
+    int hi_{ 0 };
+    std::vector<Query> parts_;
+};
+
+Query operator&&(Query a, Query b);
+Query operator||(Query a, Query b);
+Query operator!(Query q);
+
+
+// Eine Seite Tracks
+
+struct TrackPage {
+    std::vector<MusicTrack> tracks;
+    PageToken next;                 // für die nächste Seite
+    bool more{ false };             // es folgt mindestens ein weiterer Track
+};
+
+
+// Datei schreibgeschützt in den Speicher einblenden (mmap bzw. MapViewOfFile).
+// Die Daten bleiben gültig, solange das Objekt lebt.
+
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path) { open(path); }
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Blendet die Datei ein, false wenn sie nicht geöffnet werden kann
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return open_; }
+    const char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    std::string_view view() const { return { data_, size_ }; }
+
+private:
+    const char* data_{ nullptr };
+    std::size_t size_{ 0 };
+    bool open_{ false };
+};
+
+
+// Datei zum Anhängen von Journal-Einträgen; sync() schreibt die Daten bis auf
+// die Platte durch (fsync bzw. _commit). Nur verschiebbar, nicht kopierbar.
+
+class JournalFile {
+public:
+    JournalFile() = default;
+    ~JournalFile() { close(); }
+
+    JournalFile(const JournalFile&) = delete;
+    JournalFile& operator=(const JournalFile&) = delete;
+    JournalFile(JournalFile&& other) noexcept;
+    JournalFile& operator=(JournalFile&& other) noexcept;
+
+    // Öffnet (bzw. legt an) die Datei zum Anhängen
+    bool open(const std::string& path);
+    void close();
+
+    bool append(const char* data, std::size_t size);
+    bool sync();
+
+    // Verwirft den Inhalt und beginnt mit den übergebenen Bytes neu
+    bool reset(const char* data, std::size_t size);
+
+    // Ersetzt den Inhalt durch die übergebenen Bytes über eine temporäre Datei und
+    // Umbenennen: bei einem Absturz bleibt der alte oder der neue Inhalt vollständig
+    bool replace(const char* data, std::size_t size);
+
+    bool isOpen() const { return file_ != nullptr; }
+    const std::string& path() const { return path_; }
+
+private:
+    std::FILE* file_{ nullptr };
+    std::string path_;
+};
+
+
 // Bib die Tracks verwaltet mit folgenden funktionen
 // - CSV laden/speichern
-// - Tracks hinzufgen/ndern/lschen
+// - Tracks hinzufügen/ändern/löschen
 // - Suchen und auflisten
+// Threads: lesende (const) Methoden dürfen gleichzeitig aus mehreren Threads laufen,
+// auch während eines Autosaves. Intern nachgezogene Ordnungen (suggest, searchRange,
+// Jahr-Suche, query) sind dafür durch eigene Mutexe geschützt. Ändernde Methoden
+// dürfen nicht gleichzeitig mit anderen Aufrufen derselben Bib laufen.
 class MusicLibrary {
 public:
-    // Ldt Daten aus CSV-Datei
+    // Lädt Daten aus CSV-Datei (Datei wird eingeblendet, Felder ohne Kopie geparst)
     
     bool loadFromCsv(const std::string& path);
 
-    // SpeiChert die Liste in CSV-Datei
+    // Wie loadFromCsv, aber die Datei wird an Zeilengrenzen in Blöcke geteilt
+    // und auf mehreren Threads geparst (0 = alle Kerne). Ergebnis identisch zu loadFromCsv.
+    bool loadFromCsvParallel(const std::string& path, unsigned threads = 0);
+
+    // Durchsatz des letzten loadFromCsv
+    const LoadStats& lastLoadStats() const { return loadStats_; }
+
+    // Verworfene Zeilen des letzten Ladevorgangs (Zeilennummer, Spalte, Fehlerart)
+    const std::vector<CsvRejection>& lastRejections() const { return rejected_; }
+
+    // SpeiChert die Liste in CSV-Datei (blockweise in eine temporäre Datei, die danach
+    // atomar umbenannt wird; ein Absturz beim Speichern lässt die alte Datei intakt)
     
     bool saveToCsv(const std::string& path) const;
 
-    // neuen Track hinzufgen
+    // Wie saveToCsv, die Zeilen werden aber auf mehreren Threads formatiert (0 = alle Kerne).
+    // Ausgabe identisch zu saveToCsv.
+    bool saveToCsvParallel(const std::string& path, unsigned threads = 0) const;
+
+    // Speichert eine konsistente Momentaufnahme der Tracks, darf aus einem anderen Thread
+    // aufgerufen werden (siehe AutoSaver). Änderungen warten nur während des Kopierens.
+    bool saveCopyToCsv(const std::string& path, unsigned threads = 0) const;
+
+    // Wie checkpoint, aber als Momentaufnahme aus einem anderen Thread (siehe AutoSaver):
+    // nach dem Speichern werden nur die Journal-Einträge entfernt, die in der Kopie
+    // enthalten sind. Was währenddessen dazukam, bleibt im Journal.
+    bool checkpointCopy(const std::string& csvPath, unsigned threads = 0);
+
+    // Speichert die Bib als versionierten Binär-Snapshot (Zahlen als Spalten-Arrays,
+    // Texte als Offset-Tabelle + Blob) für einen schnellen Start
+
+    bool saveSnapshot(const std::string& path) const;
+
+    // Lädt einen Snapshot (eine Einblendung + Prüflauf); bei ungültiger Datei bleibt die Bib unverändert
+
+    bool loadSnapshot(const std::string& path);
+
+    // Journal öffnen: vorhandene Einträge werden auf die geladene Bib angewendet, danach
+    // hängen addTrack/updateTrack/deleteTrack kompakte Einträge an. Nach syncEvery
+    // Einträgen wird gesammelt auf die Platte geschrieben (fsync).
+    // Aufruf nach dem Laden der Basisdatei (CSV oder Snapshot).
+
+    bool openJournal(const std::string& path, std::size_t syncEvery = 64);
+
+    // Noch nicht geschriebene Journal-Einträge sofort auf die Platte bringen
+    bool syncJournal();
+
+    // Journal schließen (vorher sync)
+    void closeJournal();
+
+    // Bib als neue Basis in CSV-Datei speichern und das Journal leeren
+    bool checkpoint(const std::string& csvPath);
+
+    bool journalOpen() const { return journal_.isOpen(); }
+
+    // neuen Track hinzufügen
    
     int  addTrack(const MusicTrack& t);
+    int  addTrack(MusicTrack&& t);
+
+    // Viele Tracks auf einmal hinzufügen: Speicher wird einmal reserviert, die Texte
+    // werden in tracks selbst bereinigt (ab kParallelSanitizeMin Tracks auf threads
+    // Threads, 0 = alle Kerne). Die Tracks erhalten fortlaufende IDs, Rückgabe: erste ID.
+    int  addTracks(std::vector<MusicTrack> tracks, unsigned threads = 1);
 
     // Track aktualisieren
     bool updateTrack(int id, const MusicTrack& t);
 
-    // Track lschen
+    // Track löschen; verdichtet ab dem eingestellten Anteil gelöschter Slots
+    // (setCompactionRatio), dabei werden offene PageTokens ungültig
     bool deleteTrack(int id);
 
     // Sucht einen Track anhand ID.
    
     std::optional<MusicTrack> findById(int id) const;
 
-    // Sucht Track nach eingegebenen Text
+    // Sucht Track nach eingegebenen Text (Kopien, bequem für kleine Treffermengen)
     std::vector<MusicTrack>   search(const std::string& query, Field by) const;
 
-    // Liefert konst. Referenz auf alle Tracks.
+    // Wie search, liefert aber nur die Slots der Treffer (für viewAt). Gültig bis zur
+    // nächsten Änderung der Bib.
+    std::vector<std::size_t>  searchSlots(std::string_view query, Field by) const;
+
+    // Wie search, ruft aber fn(const MusicTrackView&) für jeden Treffer auf, ohne
+    // etwas zu kopieren. Liefert fn bool, bricht false die Suche ab.
+    template<typename Fn>
+    void forEachMatch(std::string_view query, Field by, Fn&& fn) const {
+        auto visit = [](void* ctx, std::size_t, const MusicTrackView& v) -> bool {
+            auto& f = *static_cast<std::remove_reference_t<Fn>*>(ctx);
+            if constexpr (std::is_void_v<decltype(f(v))>) {
+                f(v);
+                return true;
+            }
+            else {
+                return static_cast<bool>(f(v));
+            }
+        };
+        scanMatches_(query, by, visit, const_cast<void*>(static_cast<const void*>(&fn)));
+    }
+
+    // Seitenweise auflisten bzw. suchen: höchstens limit Tracks ab dem offset-ten Track
+    // bzw. Treffer. Die Suche hört auf, sobald die Seite voll ist.
+    TrackPage listPage(std::size_t offset, std::size_t limit) const;
+    TrackPage searchPage(std::string_view query, Field by, std::size_t offset, std::size_t limit) const;
+
+    // Nächste Seite ab einem Token (aus TrackPage::next), false wenn das Token
+    // nicht mehr gültig ist (Bib wurde verdichtet, auch durch deleteTrack, oder neu geladen)
+    bool listNext(const PageToken& from, std::size_t limit, TrackPage& out) const;
+    bool searchNext(std::string_view query, Field by, const PageToken& from, std::size_t limit, TrackPage& out) const;
+
+    // Tracks mit lo <= Jahr bzw. Dauer <= hi, aufsteigend nach dem Wert (bei gleichem
+    // Wert in Listenreihenfolge). Über einen sortierten Index: O(log n + Treffer).
+    std::vector<MusicTrack>   searchRange(RangeField by, int lo, int hi) const;
+
+    // Wie searchRange, liefert aber nur die Slots der Treffer (für viewAt)
+    std::vector<std::size_t>  searchRangeSlots(RangeField by, int lo, int hi) const;
+
+    // Tracks, auf die die Abfrage zutrifft, in Listenreihenfolge. Der Planer schätzt je
+    // Teilbedingung Trefferanteil und Kosten (über Wörterbuch-Zähler und die Indizes)
+    // und prüft billige, seltene Bedingungen zuerst. Wenn möglich werden nur Kandidaten
+    // aus einem Index geprüft statt aller Zeilen.
+    std::vector<MusicTrack>   query(const Query& q) const;
+
+    // Wie query, liefert aber nur die Slots der Treffer (für viewAt)
+    std::vector<std::size_t>  querySlots(const Query& q) const;
+
+    // Vervollständigungen für ein Präfix (ohne Groß/Klein) in Title, Artist, Album oder
+    // Genre: höchstens k Werte, die mit den meisten Tracks zuerst, bei Gleichstand
+    // alphabetisch. Schreibweisen, die sich nur in Groß/Klein unterscheiden, zählen
+    // zusammen. Für Year und Any gibt es keine Vorschläge.
+    std::vector<Suggestion> suggest(std::string_view prefix, Field by, std::size_t k = 10) const;
+
+    // Track an einem Slot (z.B. aus searchSlots) als Sicht, gültig bis zur nächsten Änderung
+    MusicTrackView viewAt(std::size_t slot) const { return cols_.view(slot); }
+
+    // Liefert alle Tracks (Sicht auf die Spalten, Elemente als MusicTrack).
    
-    const std::vector<MusicTrack>& listAll() const { return tracks_; }
+    TrackList listAll() const { return TrackList(cols_); }
+
+    // Gesamtdauer aller Tracks in Sekunden (liest nur die durationSec-Spalte)
+    long long totalDurationSec() const;
 
-    // Lscht alle Tracks 
+    // Gelöschte Tracks endgültig entfernen. deleteTrack macht das automatisch, sobald
+    // der Anteil gelöschter Slots ratio übersteigt (ratio >= 1: nur noch über compact())
+    void compact();
+    void setCompactionRatio(double ratio) { compactionRatio_ = ratio; }
+
+    // Zeilenweise Suche (search, searchSlots, forEachMatch, Seiten, query) ab minSlots
+    // Slots blockweise auf threads Threads verteilen (0 = alle Kerne, 1 = immer auf dem
+    // aufrufenden Thread). Treffer kommen in derselben Reihenfolge wie sequentiell und
+    // werden auf dem aufrufenden Thread weitergereicht; bricht der Besucher ab, hören
+    // auch die übrigen Threads auf.
+    void setParallelSearch(unsigned threads, std::size_t minSlots = kParallelSearchMin);
+
+    // Trigramm-Index für die Teilstring-Suche ein- bzw. ausschalten (Standard: aus).
+    // Kostet etwa 4 Byte pro Trigramm eines Titels, wird bei jeder Änderung mitgeführt.
+    void enableTrigramIndex(bool on = true);
+    bool trigramIndexEnabled() const { return cols_.trigramIndexed(); }
+
+    // Löscht alle Tracks 
     void clear();
 
     // Hilfsfunktion, bereinigt einen String (z.b. Leerzeichen trimmen, problematische Zeichen entfernen)
     
     static std::string sanitize(const std::string& s);
 
-    // Hilfsfunktion, Wandelt einen Track in eine CSV-Zeile um, ntig zum speichern
+    // Wie sanitize, ändert s aber direkt (ohne neuen String)
+    static void sanitizeInPlace(std::string& s);
+
+    // Hilfsfunktion, Wandelt einen Track in eine CSV-Zeile um, nötig zum speichern
    
     static std::string toCsvRow(const MusicTrack& t);
 
-    // Hilfsfunktion, liest eine CSV-Zeile und fllt daraus einen MusicTrack
+    // Hilfsfunktion, liest eine CSV-Zeile und füllt daraus einen MusicTrack
     
-    bool fromCsvRow(const std::string& row, MusicTrack& out);
+    bool fromCsvRow(std::string_view row, MusicTrack& out);
+
+    // Wie oben, liefert bei Fehlern zusätzlich Spalte und Byte-Position
+    bool fromCsvRow(std::string_view row, MusicTrack& out, CsvRowError& error);
 
 private:
-    // Interner Speicher: fr Liste aller Tracks
-    std::vector<MusicTrack> tracks_;
+    // Interner Speicher: alle Tracks spaltenweise
+    TrackColumns cols_;
+
+    // Anteil gelöschter Slots, ab dem deleteTrack verdichtet
+    double compactionRatio_{ 0.25 };
+
+    // Parallele Suche (siehe setParallelSearch)
+    unsigned searchThreads_{ 0 };
+    std::size_t parallelSearchMin_{ kParallelSearchMin };
+
+    // Threads für eine Suche über slots Slots (1 = sequentiell)
+    unsigned searchThreadsFor_(std::size_t slots) const;
 
-    // Nchste freie ID, bentigt fr hinzufgen neuer Tracks
+    // Nächste freie ID, benötigt für hinzufügen neuer Tracks
     int nextId_{ 1 };
 
-    // Stellt sicher, dass nextId_ immer grer als alle vorhandenen IDs ist
+    // Kennzahlen des letzten Ladevorgangs
+    LoadStats loadStats_;
+    std::vector<CsvRejection> rejected_;
+
+    // Änderungen an cols_ gegen Kopien aus dem Autosave-Thread schützen;
+    // Leser nehmen ihn nicht (siehe Klassenkommentar)
+    mutable OwnMutex editMutex_;
+
+    // Immer nur ein Schreibvorgang auf die CSV-Datei gleichzeitig
+    mutable OwnMutex saveMutex_;
+
+    // Journal für Änderungen (optional)
+    JournalFile journal_;
+    std::size_t journalSyncEvery_{ 64 };
+    std::size_t journalPending_{ 0 };
+    bool journalFailed_{ false };
+    std::uint64_t journalBytes_{ 0 };               // Länge der Journal-Datei
+    std::uint64_t journalEpoch_{ 0 };               // +1 bei Öffnen, Schließen und Leeren
+    std::string journalBuf_;
+
+    // Eintrag ins Journal schreiben (nur wenn geöffnet)
+    void journalAppend_(unsigned char type, const MusicTrack& t);
+
+    // syncJournal bei bereits gehaltenem editMutex_
+    bool syncJournal_();
+
+    // Journal-Einträge ab Dateianfang anwenden, liefert das Ende des letzten gültigen Eintrags
+    std::size_t replayJournal_(const char* data, std::size_t size);
+
+    // Gemeinsamer Suchkern: visit(ctx, slot, view) für jeden Treffer, false bricht ab
+    using MatchVisitor = bool (*)(void* ctx, std::size_t slot, const MusicTrackView& v);
+    void scanMatches_(std::string_view query, Field by, MatchVisitor visit, void* ctx, std::size_t fromSlot = 0) const;
+
+    // Seiten füllen ab Slot (skip Treffer werden vorher übersprungen)
+    void listFrom_(std::size_t slot, std::size_t limit, TrackPage& out) const;
+    void searchFrom_(std::string_view query, Field by, std::size_t slot, std::size_t skip,
+        std::size_t limit, TrackPage& out) const;
+
+    // Kleinster Block pro Thread beim parallelen Laden
+    static constexpr std::size_t kMinChunkBytes = 64 * 1024;
+
+    // Ab so vielen Tracks bereinigt addTracks parallel
+    static constexpr std::size_t kParallelSanitizeMin = 64 * 1024;
+
+    // Ab so vielen Slots sucht search standardmäßig parallel
+    static constexpr std::size_t kParallelSearchMin = 256 * 1024;
+
+    // Bereinigen eines einzelnen Tracks (alle vier Textfelder)
+    static void sanitizeTrack_(MusicTrack& t);
+
+    // Gemeinsame Speicherfunktion für saveToCsv/saveToCsvParallel
+    bool saveCsv_(const std::string& path, unsigned threads) const;
+
+    // Gemeinsame Ladefunktion für loadFromCsv/loadFromCsvParallel
+    bool loadMapped_(const std::string& path, unsigned threads);
+
+    // Stellt sicher, dass nextId_ immer größer als alle vorhandenen IDs ist
  
     void refreshNextId_();
 };
 
+
+// Schreibgeschützte Bib direkt auf einem eingeblendeten Snapshot (siehe saveSnapshot).
+// Es wird nichts deserialisiert: Abfragen lesen die Spalten der Datei und liefern
+// MusicTrackView-Sichten. Mehrere Prozesse teilen sich dabei den Page-Cache.
+
+class MappedLibrary {
+public:
+    // Einfacher Iterator über alle Tracks (liefert Sichten als Wert)
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = MusicTrackView;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = MusicTrackView;
+
+        const_iterator(const MappedLibrary* lib, std::size_t index) : lib_(lib), index_(index) {}
+        MusicTrackView operator*() const { return lib_->at(index_); }
+        const_iterator& operator++() { ++index_; return *this; }
+        const_iterator operator++(int) { const_iterator old = *this; ++index_; return old; }
+        bool operator==(const const_iterator& o) const { return index_ == o.index_; }
+        bool operator!=(const const_iterator& o) const { return index_ != o.index_; }
+
+    private:
+        const MappedLibrary* lib_;
+        std::size_t index_;
+    };
+
+    // Blendet einen Snapshot ein, prüft nur Kopf und Größe (sofort fertig)
+    bool open(const std::string& snapshotPath);
+    void close();
+
+    bool isOpen() const { return file_.isOpen(); }
+    std::size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+
+    // Track an Position index (0 <= index < size())
+    MusicTrackView at(std::size_t index) const;
+
+    // Sucht einen Track anhand ID (binäre Suche, wenn die ids sortiert gespeichert wurden)
+    std::optional<MusicTrackView> findById(int id) const;
+
+    // Sucht wie MusicLibrary::search, liefert aber nur Sichten
+    std::vector<MusicTrackView> search(const std::string& query, Field by) const;
+
+    // Iteration wie über listAll()
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, count_); }
+
+private:
+    MappedFile file_;
+    std::size_t count_{ 0 };
+    const char* ids_{ nullptr };
+    const char* years_{ nullptr };
+    const char* durations_{ nullptr };
+    const char* offsets_[4]{};          // title, artist, album, genre
+    const char* blobs_[4]{};
+    std::uint64_t blobBytes_[4]{};
+    std::uint64_t entries_[4]{};        // Einträge je Offset-Tabelle
+    const char* codes_[3]{};            // ab Version 2: artist, album, genre als Codes
+    bool idsSorted_{ false };
+
+    int idAt_(std::size_t index) const;
+    std::string_view text_(int column, std::size_t index) const;
+};
+
+
+// Zustand der automatischen Sicherung
+
+struct AutoSaveStatus {
+    std::size_t saves{ 0 };                                 // erfolgreiche Speicherungen
+    std::size_t failures{ 0 };                              // fehlgeschlagene Speicherungen
+    bool saving{ false };                                   // läuft gerade
+    bool lastOk{ true };
+    std::chrono::system_clock::time_point lastSaveTime{};   // Ende der letzten Speicherung
+    double lastSaveSeconds{ 0.0 };                          // Dauer der letzten Speicherung
+};
+
+
+// Speichert die Bib im Hintergrund. Nach markDirty() wird delay abgewartet, alle
+// Änderungen in dieser Zeit landen in einer Speicherung. Gespeichert wird eine
+// Momentaufnahme (checkpointCopy), der Benutzer kann währenddessen weiterarbeiten.
+// Ist ein Journal offen, werden die gespeicherten Einträge danach daraus entfernt.
+// Die Bib darf nur im Thread geändert werden, der auch markDirty() aufruft,
+// und muss den AutoSaver überleben.
+
+class AutoSaver {
+public:
+    AutoSaver(MusicLibrary& lib, std::string csvPath,
+        std::chrono::milliseconds delay = std::chrono::seconds(5));
+    ~AutoSaver();
+
+    AutoSaver(const AutoSaver&) = delete;
+    AutoSaver& operator=(const AutoSaver&) = delete;
+
+    // Nach jeder Änderung aufrufen
+    void markDirty();
+
+    // Thread beenden; offene Änderungen werden vorher gespeichert, wenn savePending
+    void stop(bool savePending = true);
+
+    AutoSaveStatus status() const;
+
+private:
+    void run_();
+
+    MusicLibrary& lib_;
+    std::string path_;
+    std::chrono::milliseconds delay_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool dirty_{ false };
+    bool stopping_{ false };
+    std::chrono::steady_clock::time_point dirtySince_;
+    AutoSaveStatus status_;
+
+    std::thread thread_;
+};
@@ -1,27 +1,28 @@
 
 /**
 * ============================================================================ =
-* MUSIK - BIBLIOTHEK  MAIN
+* MUSIK - BIBLIOTHEK – MAIN
 * ============================================================================ =
 * Datei:        main.cpp
 * Projekt : Einfache Musik - Bibliothek
 * Inhaltet :
-* -Laden / Speichern der Bibliothek(ber CSV Datei)
-* -Anzeigen, Hinzufgen, Bearbeiten, Lschen
+* -Laden / Speichern der Bibliothek(über CSV Datei)
+* -Anzeigen, Hinzufügen, Bearbeiten, Löschen
 * -Suchen nach Begriff, ID
 * -neue Bib laden
 *
 * Datum : 2025 - 12 - 22
 *
 * Bedienung :
-* -Zahlen 0..7 im UI eingegeben werden
-* -Pfade knnen bergeben werdne
-* -Beim Beenden Mglichkeit zu speichern
+* -Zahlen 0..8 im UI eingegeben werden
+* -Pfade können übergeben werdne
+* -Optional 2. Argument: Autosave-Intervall in Sekunden (z.B. main.exe library.csv 30)
+* -Beim Beenden Möglichkeit zu speichern
 * 
 *  Hinweis / Disclaimer:
-*  Fr die Gestaltung, Optimierung, Strukturierung sowie Untersttzung bei der
+*  Für die Gestaltung, Optimierung, Strukturierung sowie Unterstützung bei der
 *  Fehlersuche wurde ChatGPT verwendet. Der Code wurde jedoch
-*  eigenstndig berprft und angepasst, um den Projektanforderungen zu gengen.
+*  eigenständig überprüft und angepasst, um den Projektanforderungen zu genügen.
 * 
 * ============================================================================ =
 */
@@ -32,6 +33,12 @@
 #include <iostream>
 #include <limits>
 #include <fstream>
+#include <filesystem>
+#include <memory>
+#include <ctime>
+#include <string>
+#include <charconv>
+#include <algorithm>
 
 //-------------------Hilfsfunktionen---------------------------------
 
@@ -39,7 +46,7 @@
 
 static void printTrack(const MusicTrack& t) {
     std::cout << "ID " << t.id << " | "
-        << t.title << "  " << t.artist
+        << t.title << " — " << t.artist
         << " [" << t.album << ", " << t.year << "] "
         << t.genre << " | " << t.durationSec << "s\n";
 }
@@ -96,33 +103,202 @@ static Field fieldFromInt(int f) {
     }
 }
 
+// Zahl am Anfang von s lesen (führende Leerzeichen erlaubt), s rückt dahinter
+static bool readNumber(std::string_view& s, int& value) {
+    while (!s.empty() && s.front() == ' ') s.remove_prefix(1);
+    auto res = std::from_chars(s.data(), s.data() + s.size(), value);
+    if (res.ec != std::errc()) return false;
+    s.remove_prefix(static_cast<size_t>(res.ptr - s.data()));
+    while (!s.empty() && s.front() == ' ') s.remove_prefix(1);
+    return true;
+}
+
+// Bereich für Jahr/Dauer einlesen: "1990-1999", "1990..1999", ">=2000", ">360",
+// "<=1980", "<60" oder eine einzelne Zahl. Grenzen sind inklusive.
+static bool parseRange(std::string_view s, int& lo, int& hi) {
+    lo = std::numeric_limits<int>::min();
+    hi = std::numeric_limits<int>::max();
+    while (!s.empty() && s.front() == ' ') s.remove_prefix(1);
+
+    int v = 0;
+    if (!s.empty() && (s.front() == '>' || s.front() == '<')) {
+        const bool greater = s.front() == '>';
+        s.remove_prefix(1);
+        const bool inclusive = !s.empty() && s.front() == '=';
+        if (inclusive) s.remove_prefix(1);
+        if (!readNumber(s, v) || !s.empty()) return false;
+        if (greater) {
+            if (!inclusive && v == std::numeric_limits<int>::max()) return false;
+            lo = inclusive ? v : v + 1;
+        }
+        else {
+            if (!inclusive && v == std::numeric_limits<int>::min()) return false;
+            hi = inclusive ? v : v - 1;
+        }
+        return true;
+    }
+
+    if (!readNumber(s, lo)) return false;
+    if (s.empty()) {
+        hi = lo;
+        return true;
+    }
+    if (s.substr(0, 2) == "..") s.remove_prefix(2);
+    else if (s.front() == '-') s.remove_prefix(1);
+    else return false;
+    return readNumber(s, hi) && s.empty() && lo <= hi;
+}
+
+
+// Tracks pro Bildschirmseite bei Liste und Suche
+static constexpr size_t kPageSize = 50;
+
+// Seiten ausgeben, bis keine mehr folgt oder der Benutzer abbricht.
+// nextPage(token, page) füllt die Seite ab token. Rückgabe: Anzahl ausgegebener Tracks
+template<typename NextPage>
+static size_t printPaged(NextPage nextPage) {
+    size_t shown = 0;
+    PageToken token;
+    TrackPage page;
+    while (nextPage(token, page)) {
+        for (const auto& t : page.tracks) {
+            printTrack(t);
+        }
+        shown += page.tracks.size();
+        if (!page.more) break;
+        if (readLine("-- Enter = weiter, q = abbrechen -- ") == "q") break;
+        token = page.next;
+    }
+    return shown;
+}
+
+// Treffer-Slots (z.B. aus searchRangeSlots) seitenweise ausgeben, token.slot ist die
+// Position in slots
+static size_t printSlots(const MusicLibrary& lib, const std::vector<size_t>& slots) {
+    return printPaged([&](const PageToken& from, TrackPage& page) {
+        size_t end = std::min(slots.size(), from.slot + kPageSize);
+        page.tracks.clear();
+        for (size_t i = from.slot; i < end; ++i) page.tracks.push_back(lib.viewAt(slots[i]).toTrack());
+        page.more = end < slots.size();
+        page.next.slot = end;
+        return true;
+    });
+}
+
+
+// Binär-Snapshot und Journal liegen neben der CSV-Datei
+// (library.csv -> library.csv.snap, library.csv.journal)
+
+static std::string snapshotPathFor(const std::string& csvPath) {
+    return csvPath + ".snap";
+}
+
+static std::string journalPathFor(const std::string& csvPath) {
+    return csvPath + ".journal";
+}
+
+// Lädt bevorzugt den Snapshot, solange er nicht älter als die CSV-Datei ist,
+// sonst die CSV-Datei (danach wird der Snapshot für den nächsten Start erneuert)
+
+static bool loadLibrary(MusicLibrary& lib, const std::string& csvPath) {
+    namespace fs = std::filesystem;
+    const std::string snapPath = snapshotPathFor(csvPath);
+
+    std::error_code csvErr, snapErr;
+    auto csvTime = fs::last_write_time(csvPath, csvErr);
+    auto snapTime = fs::last_write_time(snapPath, snapErr);
+    if (csvErr) return false;
+
+    if (!snapErr && snapTime >= csvTime && lib.loadSnapshot(snapPath)) {
+        return true;
+    }
+
+    if (!lib.loadFromCsv(csvPath)) return false;
+    lib.saveSnapshot(snapPath);
+    return true;
+}
+
+// Änderungen seit dem letzten Speichern aus dem Journal nachholen und Journal öffnen
+
+static void openJournalFor(MusicLibrary& lib, const std::string& csvPath) {
+    if (!lib.openJournal(journalPathFor(csvPath))) {
+        std::cout << "Journal konnte nicht geoeffnet werden, Aenderungen nur beim Speichern gesichert.\n";
+    }
+}
+
+// Speichert CSV-Datei (leert dabei das Journal) und danach den Snapshot
+
+static bool saveLibrary(MusicLibrary& lib, const std::string& csvPath) {
+    if (!lib.checkpoint(csvPath)) return false;
+    lib.saveSnapshot(snapshotPathFor(csvPath));
+    return true;
+}
+
+
+// Zeigt den Stand der automatischen Sicherung im Menü an
+
+static void printAutoSaveStatus(const AutoSaver& saver) {
+    AutoSaveStatus st = saver.status();
+    if (st.saving) {
+        std::cout << "Automatische Sicherung laeuft...\n";
+    }
+    else if (st.saves + st.failures > 0) {
+        std::time_t when = std::chrono::system_clock::to_time_t(st.lastSaveTime);
+        char buf[16];
+        std::strftime(buf, sizeof(buf), "%H:%M:%S", std::localtime(&when));
+        std::cout << "Letzte automatische Sicherung: " << buf << " (" << st.lastSaveSeconds << " s"
+            << (st.lastOk ? "" : ", FEHLGESCHLAGEN") << ")\n";
+    }
+}
+
 
 // -----------------------------Hauptprogramm---------------------------------------------------
 
 int main(int argc, char** argv) {
-    // Standardpfad angeben, ntig wenn bei Start bereits Bibliothek mit Tracks vorhanden sein soll
+    // Standardpfad angeben, nötig wenn bei Start bereits Bibliothek mit Tracks vorhanden sein soll
     std::string path = "C:\\Software Engineering Labor\\MusicManager\\MusicManager\\library.csv";
 
-    // Wenn ein Pfad Kommandozeilenargument bergeben wurde, bergebenen Pfad nnutzen
+    // Wenn ein Pfad Kommandozeilenargument übergeben wurde, übergebenen Pfad nnutzen
     if (argc >= 2) {
         path = argv[1];
     }
 
-    MusicLibrary lib;
+    // Autosave nur, wenn ein Intervall übergeben wurde
+    int autosaveSec = 0;
+    if (argc >= 3) {
+        try { autosaveSec = std::stoi(argv[2]); }
+        catch (...) { autosaveSec = 0; }
+    }
 
-    // Versuche initial zu laden (load CSV)
-    if (lib.loadFromCsv(path)) {
-        std::cout << "Bibliothek geladen aus: " << path << "\n";
+    MusicLibrary lib;
+    std::unique_ptr<AutoSaver> saver;
+
+    // Versuche initial zu laden (Snapshot oder CSV)
+    if (loadLibrary(lib, path)) {
+        const LoadStats& st = lib.lastLoadStats();
+        std::cout << "Bibliothek geladen aus: " << path << "\n"
+            << st.rows << " Titel in " << st.seconds << " s ("
+            << st.mbPerSec() << " MB/s, " << st.rowsPerSec() << " Zeilen/s)\n";
+        if (st.rejected > 0) {
+            std::cout << st.rejected << " ungueltige Zeilen verworfen (erste: Zeile "
+                << lib.lastRejections().front().line << ")\n";
+        }
     }
     else {
         std::cout << "Keine bestehende Bibliothek gefunden. Eine neue wird gefuehrt unter: " << path << "\n";
     }
+    openJournalFor(lib, path);
+    if (autosaveSec > 0) {
+        saver = std::make_unique<AutoSaver>(lib, path, std::chrono::seconds(autosaveSec));
+    }
 
-    // Einfaches Hauptmen im UI, Auswahl fr Benutzere
+    // Einfaches Hauptmenü im UI, Auswahl für Benutzere
     bool running = true;
     while (running) {
         std::cout << "\n=== Musik-Bibliothek ===\n"
-            << "Aktueller Pfad: " << path << "\n"
+            << "Aktueller Pfad: " << path << "\n";
+        if (saver) printAutoSaveStatus(*saver);
+        std::cout
             << "1) Alle Titel anzeigen\n"
             << "2) Titel hinzufuegen\n"
             << "3) Titel bearbeiten\n"
@@ -130,12 +306,13 @@ int main(int argc, char** argv) {
             << "5) Suchen\n"
             << "6) Speichern\n"
             << "7) Andere Bibliothek laden (Pfad eingeben)\n"
+            << "8) Abfrage (z.B. artist:queen AND year >= 2000 AND genre = Pop)\n"
             << "0) Beenden\n"
             << "Auswahl: ";
 
         int choice;
         if (!(std::cin >> choice)) {
-            // Wenn hier die Eingabe fehlschlgt, wird beendet
+            // Wenn hier die Eingabe fehlschlägt, wird beendet
             break;
         }
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
@@ -143,24 +320,26 @@ int main(int argc, char** argv) {
         switch (choice) {
         case 1: {
             // Alle Titel anzeigen
-            const auto& list = lib.listAll();
-            if (list.empty()) {
+            size_t shown = printPaged([&](const PageToken& from, TrackPage& page) {
+                return lib.listNext(from, kPageSize, page);
+            });
+            const TrackList all = lib.listAll();
+            if (shown == 0 && all.empty()) {
                 std::cout << "Keine Titel vorhanden.\n";
             }
             else {
-                for (const auto& t : list) {
-                    printTrack(t);
-                }
+                std::cout << all.size() << " Titel, Gesamtdauer " << lib.totalDurationSec() << "s\n";
             }
             break;
         }
 
         case 2: {
-            // Titel hinzufgen
+            // Titel hinzufügen
             std::cout << "Neuen Titel eingeben:\n";
             MusicTrack t = promptTrack();
             int id = lib.addTrack(t);
             std::cout << "Hinzugefuegt mit ID: " << id << "\n";
+            if (saver) saver->markDirty();
             break;
         }
 
@@ -184,6 +363,7 @@ int main(int argc, char** argv) {
             MusicTrack t = promptTrack();
             if (lib.updateTrack(id, t)) {
                 std::cout << "Aktualisiert.\n";
+                if (saver) saver->markDirty();
             }
             else {
                 std::cout << "Fehler beim Aktualisieren.\n";
@@ -192,7 +372,7 @@ int main(int argc, char** argv) {
         }
 
         case 4: {
-            // Titel lschen
+            // Titel löschen
             std::cout << "ID zum Loeschen: ";
             int id;
             if (!(std::cin >> id)) { std::cin.clear(); }
@@ -200,6 +380,7 @@ int main(int argc, char** argv) {
 
             if (lib.deleteTrack(id)) {
                 std::cout << "Geloescht.\n";
+                if (saver) saver->markDirty();
             }
             else {
                 std::cout << "Nicht gefunden.\n";
@@ -208,31 +389,39 @@ int main(int argc, char** argv) {
         }
 
         case 5: {
-            // Suchen mit Feld-Auswahl (0..5)
-            std::string q = readLine("Suchbegriff: ");
+            // Suchen mit Feld-Auswahl (0..6), Jahr und Dauer auch als Bereich
+            std::string q = readLine("Suchbegriff (Jahr/Dauer auch 1990-1999, >=2000, <180): ");
 
-            std::cout << "Feld (0=Any,1=Title,2=Artist,3=Album,4=Genre,5=Year): ";
+            std::cout << "Feld (0=Any,1=Title,2=Artist,3=Album,4=Genre,5=Year,6=Dauer): ";
             int f;
             if (!(std::cin >> f)) { std::cin.clear(); f = 0; }
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 
-            Field by = fieldFromInt(f);
-            auto res = lib.search(q, by);
-
-            if (res.empty()) {
-                std::cout << "Keine Treffer.\n";
+            size_t shown = 0;
+            int lo, hi;
+            if (f == 5 || f == 6) {
+                if (!parseRange(q, lo, hi)) {
+                    std::cout << "Ungueltiger Bereich.\n";
+                    break;
+                }
+                shown = printSlots(lib, lib.searchRangeSlots(f == 5 ? RangeField::Year : RangeField::Duration, lo, hi));
             }
             else {
-                for (const auto& t : res) {
-                    printTrack(t);
-                }
+                Field by = fieldFromInt(f);
+                shown = printPaged([&](const PageToken& from, TrackPage& page) {
+                    return lib.searchNext(q, by, from, kPageSize, page);
+                });
+            }
+
+            if (shown == 0) {
+                std::cout << "Keine Treffer.\n";
             }
             break;
         }
 
         case 6: {
             // Speichern
-            if (lib.saveToCsv(path)) {
+            if (saveLibrary(lib, path)) {
                 std::cout << "Gespeichert unter: " << path << "\n";
             }
             else {
@@ -246,9 +435,14 @@ int main(int argc, char** argv) {
             std::string newPath = readLine("Neuen Pfad eingeben (z.B. C:\\Software Engineering Labor\\MusicManager\\MusicManager\\library.csv:\n> ");
 
             MusicLibrary newLib;
-            if (newLib.loadFromCsv(newPath)) {
+            if (loadLibrary(newLib, newPath)) {
+                openJournalFor(newLib, newPath);
+                saver.reset();                  // offene Änderungen der alten Bib noch sichern
                 lib = std::move(newLib);
                 path = newPath;
+                if (autosaveSec > 0) {
+                    saver = std::make_unique<AutoSaver>(lib, path, std::chrono::seconds(autosaveSec));
+                }
                 std::cout << "Bibliothek geladen aus: " << path << "\n";
             }
             else {
@@ -260,8 +454,14 @@ int main(int argc, char** argv) {
                 std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 
                 if (ans == 'j' || ans == 'J') {
+                    saver.reset();
+                    lib.closeJournal();
                     lib.clear();
                     path = newPath;
+                    openJournalFor(lib, path);
+                    if (autosaveSec > 0) {
+                        saver = std::make_unique<AutoSaver>(lib, path, std::chrono::seconds(autosaveSec));
+                    }
                     std::cout << "Leere Bibliothek gesetzt. Du kannst Titel hinzufuegen und speichern.\n";
                 }
                 else {
@@ -271,9 +471,26 @@ int main(int argc, char** argv) {
             break;
         }
 
+        case 8: {
+            // Zusammengesetzte Abfrage als Text
+            std::string text = readLine("Abfrage: ");
+            std::string error;
+            std::optional<Query> q = Query::parse(text, &error);
+            if (!q) {
+                std::cout << "Ungueltige Abfrage: " << error << "\n";
+                break;
+            }
+
+            if (printSlots(lib, lib.querySlots(*q)) == 0) {
+                std::cout << "Keine Treffer.\n";
+            }
+            break;
+        }
+
         case 0: {
-            // Optional beim Beenden speichern
-            lib.saveToCsv(path);
+            // Optional beim Beenden speichern (Autosave vorher anhalten, es wird ohnehin alles gespeichert)
+            if (saver) saver->stop(false);
+            saveLibrary(lib, path);
             running = false;
             break;
         }
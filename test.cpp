@@ -1,6 +1,9 @@
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
 #include "MusicManager.hpp"
+#include <fstream>
+#include <climits>
+#include <stdexcept>
 
 
 //-------------------------------------------------UNIT-TESTS-----------------------------------------------------------
@@ -11,7 +14,7 @@
 
 
 
-static MusicTrack makeTrack(                    //Hilfsfunktion fr die erstellung von einem Track
+static MusicTrack makeTrack(                    //Hilfsfunktion für die erstellung von einem Track
     const std::string& title,
     const std::string& artist,
     const std::string& album,
@@ -38,9 +41,9 @@ TEST_CASE("addTrack vergibt fortlaufende ID richtig", "(Test Methode addTrack)")
     int id1 = lib.addTrack(makeTrack("Song A", "Artist A", "Album A", 2020, "Pop", 180));       //erstellen von zwei Tracks                 
     int id2 = lib.addTrack(makeTrack("Song B", "Artist B", "Album B", 2021, "Rock", 200));      
 
-    REQUIRE(id1 == 1);                                                                          //IDs berprfen
+    REQUIRE(id1 == 1);                                                                          //IDs überprüfen
     REQUIRE(id2 == 2);
-    REQUIRE(lib.listAll().size() == 2);                                                         //berprfen ob nur zwei Tracks in neuer Bib sind
+    REQUIRE(lib.listAll().size() == 2);                                                         //Überprüfen ob nur zwei Tracks in neuer Bib sind
 }
 
 
@@ -54,7 +57,7 @@ TEST_CASE("findById findet Track", "(Test Methode findById()") {
     auto result = lib.findById(id);                                                             //erstellten Track suchen   
 
     REQUIRE(result.has_value());                                                                //track gefunden
-    REQUIRE(result->title == "Test");                                                           //berprfen der Metadaten  
+    REQUIRE(result->title == "Test");                                                           //Überprüfen der Metadaten  
     REQUIRE(result->artist == "Tester");    
 }
 
@@ -62,11 +65,11 @@ TEST_CASE("findById findet Track", "(Test Methode findById()") {
 
 
 
-TEST_CASE("findById fr Fall das ID nicht vergeben ist", "(Test Methode findById()") {
+TEST_CASE("findById für Fall das ID nicht vergeben ist", "(Test Methode findById()") {
     MusicLibrary lib;
 
     auto result = lib.findById(999);                                                            //Suchen nach nicht vorhandener ID               
-    REQUIRE_FALSE(result.has_value());                                                          //muss False zurckgeben
+    REQUIRE_FALSE(result.has_value());                                                          //muss False zurückgeben
 }               
 
 
@@ -83,7 +86,7 @@ TEST_CASE("Aktualisieren MataDaten von Track", "(Test Methode updateTrack()") {
     REQUIRE(ok);                                                                                //Aktualisierung erfolgreich
 
     auto updated = lib.findById(id);
-    REQUIRE(updated->title == "Neu");                                                           //berprfung ob neue MetaDaten gespeichert wurden
+    REQUIRE(updated->title == "Neu");                                                           //Überprüfung ob neue MetaDaten gespeichert wurden
     REQUIRE(updated->year == 2022);
 }
 
@@ -91,7 +94,7 @@ TEST_CASE("Aktualisieren MataDaten von Track", "(Test Methode updateTrack()") {
 
 
 
-TEST_CASE("Aktualisieren MetaDaten von Track mit falscher ID Eingabe", "(Test Methode updateTrack()") {
+TEST_CASE("Aktualisieren MetaDaten von Track mit falscher ID Eingabe", "´(Test Methode updateTrack()") {
     MusicLibrary lib;
     MusicTrack t = makeTrack("X", "Y", "Z", 2000, "Pop", 100);
 
@@ -102,11 +105,11 @@ TEST_CASE("Aktualisieren MetaDaten von Track mit falscher ID Eingabe", "
 
 
 
-TEST_CASE("Tracklschen", "Test Methode deleteTrack") {                                         
+TEST_CASE("Tracklöschen", "Test Methode deleteTrack") {                                         
     MusicLibrary lib;
     int id = lib.addTrack(makeTrack("Delete Me", "A", "B", 2010, "Pop", 120));                  //Track erstellen und in neuer Bib speichern
 
-    REQUIRE(lib.deleteTrack(id));                                                               //erstellten Track lschen
+    REQUIRE(lib.deleteTrack(id));                                                               //erstellten Track löschen
     REQUIRE(lib.listAll().empty());                                                             //Bib muss nun wieder leer sein
 }
 
@@ -114,9 +117,9 @@ TEST_CASE("Trackl
 
 
 
-TEST_CASE("Track lschen mit nicht vergebener ID", "Test Methode deleteTrack") {
+TEST_CASE("Track löschen mit nicht vergebener ID", "´Test Methode deleteTrack") {
     MusicLibrary lib;                                                   
-    REQUIRE_FALSE(lib.deleteTrack(123));                                                        //ID nicht vergeben muss False zurckgeben
+    REQUIRE_FALSE(lib.deleteTrack(123));                                                        //ID nicht vergeben muss False zurückgeben
 }       
 
 
@@ -143,7 +146,7 @@ TEST_CASE("search mit alles druchsuchen", "Test Methode search") {
     MusicLibrary lib;   
     lib.addTrack(makeTrack("Song1", "Queen", "Best Of", 1980, "Rock", 210));                    //Erstellen von neuen Track
 
-    auto res = lib.search("queen", Field::Any);                                                 //suchen nach Knstler z.b
+    auto res = lib.search("queen", Field::Any);                                                 //suchen nach Künstler z.b
     REQUIRE(res.size() == 1);                                                                   //Track gefunden
 }
 
@@ -188,18 +191,1234 @@ TEST_CASE("saveToCsv und loadFromCsv funktionieren zusammen", "test Funktion sav
 
 
 
+TEST_CASE("loadFromCsv liest eingeblendete Datei mit Sonderfaellen", "(Test Methode loadFromCsv)") {
+    const std::string path = "test_mmap.csv";
+
+    {
+        std::ofstream f(path, std::ios::binary);                                                //CSV mit CRLF, Leerzeilen, Leerzeichen und kaputter Zeile
+        f << "id,title,artist,album,year,genre,durationSec\r\n"
+          << "7, Song A ,Artist A,Album A,1999,Pop,180\r\n"
+          << "\r\n"
+          << "x,kaputt,B,C,2000,Rock,100\r\n"
+          << "3,Song B,Artist B,Album B,+2001,Rock,200";                                         //letzte Zeile ohne Zeilenumbruch
+    }
+
+    MusicLibrary lib;
+    REQUIRE(lib.loadFromCsv(path));
+    REQUIRE(lib.listAll().size() == 2);                                                         //kaputte Zeile wird verworfen
+    REQUIRE(lib.listAll()[0].title == "Song A");                                                //Felder werden getrimmt
+    REQUIRE(lib.listAll()[1].year == 2001);
+    REQUIRE(lib.lastLoadStats().rows == 2);                                                     //Durchsatzzaehler gefuellt
+    REQUIRE(lib.lastLoadStats().bytes > 0);
+    REQUIRE(lib.addTrack(MusicTrack{}) == 8);                                                   //naechste ID hinter hoechster ID
+
+    std::remove(path.c_str());
+}
+
+
+
+
+
+TEST_CASE("loadFromCsvParallel liefert dasselbe Ergebnis wie loadFromCsv", "(Test Methode loadFromCsvParallel)") {
+    const std::string path = "test_parallel.csv";
+
+    {
+        std::ofstream f(path, std::ios::binary);                                                //gross genug fuer mehrere Bloecke
+        f << "id,title,artist,album,year,genre,durationSec\n";
+        for (int i = 1; i <= 20000; ++i) {
+            f << i << ",Song " << i << ",Artist " << i % 97 << ",Album,"
+              << 1950 + i % 70 << ",Pop," << 100 + i % 300 << "\n";
+            if (i % 1000 == 0) f << "kaputt\n\n";                                             //ungueltige Zeilen und Leerzeilen
+        }
+    }
+
+    MusicLibrary seq;
+    MusicLibrary par;
+    REQUIRE(seq.loadFromCsv(path));
+    REQUIRE(par.loadFromCsvParallel(path, 4));
+
+    REQUIRE(par.listAll().size() == 20000);
+    REQUIRE(par.listAll().size() == seq.listAll().size());
+    for (size_t i = 0; i < seq.listAll().size(); ++i) {                                        //gleiche Reihenfolge und Inhalte
+        REQUIRE(par.listAll()[i].id == seq.listAll()[i].id);
+        REQUIRE(par.listAll()[i].title == seq.listAll()[i].title);
+    }
+    REQUIRE(par.addTrack(MusicTrack{}) == 20001);                                               //nextId_ einmal ueber alle Daten
+
+    std::remove(path.c_str());
+}
+
+
+
+
+
+TEST_CASE("Blockweiser Scanner stimmt mit fromCsvRow ueberein", "(Test Methode loadFromCsv)") {
+    const std::string path = "test_scanner.csv";
+    std::vector<std::string> rows;
+
+    for (int i = 1; i <= 300; ++i) {                                                            //Felder unterschiedlicher Laenge ueber 32-Byte-Grenzen
+        std::string pad(static_cast<size_t>(i % 45), 'x');
+        rows.push_back(std::to_string(i) + ", T" + pad + " ,A" + pad + ",B,19" + std::to_string(10 + i % 90) + ",G,\t" + std::to_string(i));
+    }
+    rows.push_back("301,T,A,B,2000,G,100,");                                                     //abschliessendes Komma wird ignoriert
+    rows.push_back("302,T,A,B,2000,G,100,,");                                                    //zu viele Felder
+    rows.push_back("303,T,A,B,2000,G");                                                          //zu wenige Felder
+    rows.push_back("   ");
+
+    {
+        std::ofstream f(path, std::ios::binary);
+        f << "id,title,artist,album,year,genre,durationSec\n";
+        for (const auto& r : rows) f << r << "\r\n";
+    }
+
+    MusicLibrary lib;
+    REQUIRE(lib.loadFromCsv(path));
+
+    MusicLibrary ref;
+    std::vector<MusicTrack> expected;
+    for (const auto& r : rows) {                                                                //Referenz: Zeile fuer Zeile
+        MusicTrack t;
+        if (ref.fromCsvRow(r, t)) expected.push_back(t);
+    }
+
+    REQUIRE(expected.size() == 301);
+    REQUIRE(lib.listAll().size() == expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        REQUIRE(lib.listAll()[i].title == expected[i].title);
+        REQUIRE(lib.listAll()[i].artist == expected[i].artist);
+        REQUIRE(lib.listAll()[i].durationSec == expected[i].durationSec);
+    }
+
+    std::remove(path.c_str());
+}
+
+
+
+
+
+TEST_CASE("fromCsvRow meldet Spalte und Position des Fehlers", "(Test Methode fromCsvRow)") {
+    MusicLibrary lib;
+    MusicTrack t;
+    CsvRowError err;
+
+    REQUIRE(lib.fromCsvRow("1,T,A,B,2000,G,120", t, err));                                      //gueltige Zeile
+    REQUIRE(err.code == CsvError::None);
+
+    REQUIRE(lib.fromCsvRow("1,T,A,B,19x9,G,120", t, err));                                      //wie bei stoi wird "19x9" als 19 gelesen
+    REQUIRE(t.year == 19);
+
+    REQUIRE_FALSE(lib.fromCsvRow("1,T,A,B,abc,G,120", t, err));
+    REQUIRE(err.code == CsvError::InvalidNumber);
+    REQUIRE(err.column == 4);                                                                   //Spalte year
+    REQUIRE(err.offset == 8);                                                                   //Byte-Position von "abc"
+
+    REQUIRE_FALSE(lib.fromCsvRow("1,T,A,B,2000,G,99999999999", t, err));
+    REQUIRE(err.code == CsvError::OutOfRange);
+    REQUIRE(err.column == 6);
+
+    REQUIRE_FALSE(lib.fromCsvRow("1,T,A,B,2000", t, err));
+    REQUIRE(err.code == CsvError::FieldCount);
+    REQUIRE(err.column == 5);                                                                   //erste fehlende Spalte
+}
+
+
+
+
+
+TEST_CASE("loadFromCsv meldet verworfene Zeilen mit Zeilennummer", "(Test Methode loadFromCsv)") {
+    const std::string path = "test_rejected.csv";
+
+    {
+        std::ofstream f(path, std::ios::binary);
+        f << "id,title,artist,album,year,genre,durationSec\n";
+        for (int i = 1; i <= 5000; ++i) {
+            if (i % 1000 == 0) f << "kaputt,T,A,B,2000,G,1\n";                                  //id keine Zahl
+            else if (i == 2500) f << "\n";                                                      //Leerzeile zaehlt nicht als Fehler
+            else f << i << ",Titel mit etwas mehr Text " << i << ",Artist,Album,2000,Pop,180\n";
+        }
+    }
+
+    MusicLibrary seq;
+    MusicLibrary par;
+    REQUIRE(seq.loadFromCsv(path));
+    REQUIRE(par.loadFromCsvParallel(path, 3));
+
+    for (const MusicLibrary* lib : { &seq, &par }) {
+        REQUIRE(lib->lastLoadStats().rejected == 5);
+        REQUIRE(lib->lastRejections().size() == 5);
+        REQUIRE(lib->lastRejections()[0].line == 1001);                                         //Kopfzeile ist Zeile 1
+        REQUIRE(lib->lastRejections()[4].line == 5001);
+        REQUIRE(lib->lastRejections()[0].error.column == 0);
+    }
+
+    std::remove(path.c_str());
+}
+
+
+
+
+
+TEST_CASE("saveSnapshot und loadSnapshot liefern dieselbe Bib", "(Test Methode saveSnapshot/loadSnapshot)") {
+    const std::string path = "test_library.snap";
+
+    MusicLibrary lib;
+    lib.addTrack(makeTrack("Song A", "Artist A", "Album A", 1999, "Pop", 180));
+    lib.addTrack(makeTrack("", "Artist B", "", 2005, "Rock", 240));                             //leere Textfelder
+    lib.addTrack(makeTrack("Song C", "Artist C", "Album C", 2010, "Jazz", 300));
+    lib.deleteTrack(2);
+    REQUIRE(lib.saveSnapshot(path));
+
+    MusicLibrary loaded;
+    REQUIRE(loaded.loadSnapshot(path));
+    REQUIRE(loaded.listAll().size() == 2);
+    REQUIRE(loaded.listAll()[1].id == 3);
+    REQUIRE(loaded.listAll()[1].title == "Song C");
+    REQUIRE(loaded.listAll()[1].genre == "Jazz");
+    REQUIRE(loaded.listAll()[1].durationSec == 300);
+    REQUIRE(loaded.addTrack(makeTrack("Neu", "X", "Y", 2020, "Pop", 100)) == 4);
+
+    std::remove(path.c_str());
+}
+
+
+
+
+
+TEST_CASE("loadSnapshot lehnt beschaedigte Dateien ab", "(Test Methode loadSnapshot)") {
+    const std::string path = "test_broken.snap";
+
+    MusicLibrary lib;
+    lib.addTrack(makeTrack("Song A", "Artist A", "Album A", 1999, "Pop", 180));
+    REQUIRE(lib.saveSnapshot(path));
+
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);                            //abgeschnittene Datei
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size() - 8));
+    }
+    REQUIRE_FALSE(lib.loadSnapshot(path));
+    REQUIRE(lib.listAll().size() == 1);                                                         //Bib bleibt unveraendert
+
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);                            //falsche Version
+        std::string changed = bytes;
+        changed[8] = 99;
+        out.write(changed.data(), static_cast<std::streamsize>(changed.size()));
+    }
+    REQUIRE_FALSE(lib.loadSnapshot(path));
+
+    std::remove(path.c_str());
+}
+
+
+
+
+
+TEST_CASE("MappedLibrary beantwortet Abfragen direkt aus dem Snapshot", "(Test Klasse MappedLibrary)") {
+    const std::string path = "test_mapped.snap";
+
+    MusicLibrary lib;
+    lib.addTrack(makeTrack("Hello World", "Alice", "Album1", 2020, "Pop", 180));
+    lib.addTrack(makeTrack("Goodbye", "Bob", "Album2", 2021, "Rock", 200));
+    lib.addTrack(makeTrack("Hello Again", "Carol", "Album3", 2021, "Jazz", 220));
+    REQUIRE(lib.saveSnapshot(path));
+
+    MappedLibrary mapped;
+    REQUIRE(mapped.open(path));
+    REQUIRE(mapped.size() == 3);
+
+    auto found = mapped.findById(2);                                                            //Suche nach ID
+    REQUIRE(found.has_value());
+    REQUIRE(found->title == "Goodbye");
+    REQUIRE_FALSE(mapped.findById(99).has_value());
+
+    auto res = mapped.search("HELLO", Field::Title);                                            //gleiche Treffer wie MusicLibrary::search
+    REQUIRE(res.size() == lib.search("HELLO", Field::Title).size());
+    REQUIRE(res[1].artist == "Carol");
+    REQUIRE(mapped.search("2021", Field::Year).size() == 2);
+
+    int total = 0;
+    for (const MusicTrackView& v : mapped) total += v.durationSec;                             //Iteration wie listAll
+    REQUIRE(total == 600);
+    REQUIRE(mapped.at(0).toTrack().album == "Album1");
+
+    lib.clear();                                                                                //Speichern über die eingeblendete Datei
+    lib.addTrack(makeTrack("X", "Y", "Z", 2000, "Pop", 1));
+    REQUIRE(lib.saveSnapshot(path));
+    REQUIRE(mapped.size() == 3);                                                                //Sicht behält die alten Daten
+    REQUIRE(mapped.at(2).title == "Hello Again");
+    REQUIRE(mapped.findById(3)->album == "Album3");
+    MappedLibrary reopened;
+    REQUIRE(reopened.open(path));
+    REQUIRE(reopened.size() == 1);
+
+    reopened.close();
+    mapped.close();
+    std::remove(path.c_str());
+}
+
+
+
+
+
+TEST_CASE("Snapshot speichert Woerterbuecher und Codes und laedt sie am Stueck", "(Test Methode saveSnapshot/loadSnapshot)") {
+    const std::string path = "test_dict.snap";
+
+    MusicLibrary lib;
+    lib.addTrack(makeTrack("Bohemian Rhapsody", "Queen", "A Night at the Opera", 1975, "Rock", 354));
+    lib.addTrack(makeTrack("Love of My Life", "Queen", "A Night at the Opera", 1975, "Rock", 219));
+    lib.addTrack(makeTrack("Radio Gaga", "queen", "The Works", 1984, "Pop", 348));              //andere Schreibweise, eigener Eintrag
+    lib.addTrack(makeTrack("So What", "Miles Davis", "Kind of Blue", 1959, "Jazz", 562));
+    REQUIRE(lib.saveSnapshot(path));
+
+    MusicLibrary loaded;
+    loaded.enableTrigramIndex();                                                                //Index wird beim Laden mit aufgebaut
+    REQUIRE(loaded.loadSnapshot(path));
+    REQUIRE(loaded.listAll().size() == 4);
+    REQUIRE(loaded.findById(3)->artist == "queen");
+    REQUIRE(loaded.findById(2)->album == "A Night at the Opera");
+    REQUIRE(loaded.search("QUEEN", Field::Artist).size() == 3);
+    REQUIRE(loaded.search("opera", Field::Album).size() == 2);
+    REQUIRE(loaded.search("rhaps", Field::Title).size() == 1);
+    auto sug = loaded.suggest("Que", Field::Artist);                                            //Schreibweisen zählen zusammen
+    REQUIRE(sug.size() == 1);
+    REQUIRE(sug[0].count == 3);
+
+    loaded.addTrack(makeTrack("Blue in Green", "Miles Davis", "Kind of Blue", 1959, "Jazz", 337));
+    REQUIRE(loaded.addTrack(makeTrack("X", "Y", "Z", 2000, "Pop", 1)) == 6);                     //IDs laufen weiter
+    REQUIRE(loaded.search("miles", Field::Artist).size() == 2);
+
+    MappedLibrary mapped;                                                                       //Sicht löst Codes über die Wörterbücher auf
+    REQUIRE(mapped.open(path));
+    REQUIRE(mapped.at(1).artist == "Queen");
+    REQUIRE(mapped.at(2).artist == "queen");
+    REQUIRE(mapped.at(3).genre == "Jazz");
+    REQUIRE(mapped.search("night", Field::Album).size() == 2);
+    mapped.close();
+
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);                            //Interpret-Code ausserhalb des Woerterbuchs
+        std::string changed = bytes;
+        const size_t codes = 96 + 3 * 16;                                                       //Kopf, dann ids/Jahre/Dauern
+        changed[codes] = changed[codes + 1] = changed[codes + 2] = changed[codes + 3] = '\x7f';
+        out.write(changed.data(), static_cast<std::streamsize>(changed.size()));
+    }
+    REQUIRE_FALSE(loaded.loadSnapshot(path));
+    REQUIRE(loaded.listAll().size() == 6);                                                      //Bib bleibt unveraendert
+    REQUIRE(mapped.open(path));                                                                 //Sicht prüft nur den Kopf ...
+    REQUIRE(mapped.at(0).artist.empty());                                                       //... liefert für den Code aber nichts
+    REQUIRE(mapped.at(1).artist == "Queen");
+    mapped.close();
+
+    std::remove(path.c_str());
+}
 
 
 
 
 
+TEST_CASE("Journal wird nach Neustart auf die Basis angewendet", "(Test Methode openJournal/checkpoint)") {
+    const std::string csv = "test_journal.csv";
+    const std::string journal = "test_journal.csv.journal";
+    std::remove(journal.c_str());
 
+    {
+        MusicLibrary lib;
+        lib.addTrack(makeTrack("Basis", "A", "B", 2000, "Pop", 100));
+        REQUIRE(lib.saveToCsv(csv));                                                            //Basisdatei mit einem Track
+
+        REQUIRE(lib.openJournal(journal, 2));
+        int id = lib.addTrack(makeTrack("Neu", "C", "D", 2001, "Rock", 200));                   //Aenderungen landen nur im Journal
+        lib.updateTrack(1, makeTrack("Basis geaendert", "A", "B", 2000, "Pop", 100));
+        lib.deleteTrack(id);
+        lib.addTrack(makeTrack("Bleibt", "E", "F", 2002, "Jazz", 300));
+    }
+
+    {
+        std::ofstream f(journal, std::ios::binary | std::ios::app);                             //abgeschnittener Eintrag wie nach Absturz
+        f.write("\x30\x00\x00\x00\x01\x02", 6);
+    }
+
+    {
+        MusicLibrary lib;
+        REQUIRE(lib.loadFromCsv(csv));
+        REQUIRE(lib.listAll().size() == 1);
+        REQUIRE(lib.openJournal(journal));                                                      //Journal nachholen
+        REQUIRE(lib.listAll().size() == 2);
+        REQUIRE(lib.listAll()[0].title == "Basis geaendert");
+        REQUIRE(lib.listAll()[1].title == "Bleibt");
+        REQUIRE(lib.listAll()[1].id == 3);
+        REQUIRE(lib.addTrack(makeTrack("X", "Y", "Z", 2003, "Pop", 50)) == 4);                  //IDs aus dem Journal werden nicht neu vergeben
+
+        REQUIRE(lib.checkpoint(csv));                                                           //Journal in die Basis uebernehmen
+    }
+
+    {
+        MusicLibrary lib;
+        REQUIRE(lib.loadFromCsv(csv));
+        REQUIRE(lib.listAll().size() == 3);
+        REQUIRE(lib.openJournal(journal));                                                      //Journal ist leer
+        REQUIRE(lib.listAll().size() == 3);
+        lib.updateTrack(3, makeTrack("Bleibt geaendert", "E", "F", 2004, "Jazz", 300));
+    }
+
+    {
+        MusicLibrary lib;                                                                       //Basis ohne Track 3: Aenderung legt ihn an
+        lib.addTrack(makeTrack("Andere Basis", "A", "B", 2000, "Pop", 100));
+        REQUIRE(lib.openJournal(journal));
+        REQUIRE(lib.listAll().size() == 2);
+        REQUIRE(lib.findById(3)->title == "Bleibt geaendert");
+        REQUIRE(lib.findById(3)->year == 2004);
+        REQUIRE(lib.addTrack(makeTrack("X", "Y", "Z", 2003, "Pop", 50)) == 4);
+    }
+
+    std::remove(journal.c_str());
+    {
+        std::ofstream f(csv, std::ios::trunc);                                                  //importierte Basis mit ID INT_MAX
+        f << "id,title,artist,album,year,genre,durationSec\n";
+        f << "5,Fuenf,A,B,2000,Pop,100\n";
+        f << INT_MAX << ",Letzte,A,B,2000,Pop,100\n";
+    }
+    {
+        MusicLibrary lib;
+        REQUIRE(lib.loadFromCsv(csv));
+        REQUIRE(lib.openJournal(journal, 1));
+        REQUIRE(lib.updateTrack(INT_MAX, makeTrack("Letzte geaendert", "A", "B", 2001, "Pop", 100)));
+        REQUIRE(lib.addTrack(makeTrack("Sechs", "C", "D", 2002, "Rock", 200)) == 6);            //nextId laeuft nicht ueber
+        REQUIRE(lib.deleteTrack(5));
+    }
+    {
+        std::ifstream in(journal, std::ios::binary | std::ios::ate);
+        const auto before = in.tellg();
+        in.close();
+
+        MusicLibrary lib;
+        REQUIRE(lib.loadFromCsv(csv));
+        REQUIRE(lib.openJournal(journal));                                                      //Eintrag mit INT_MAX und alle danach bleiben
+        std::ifstream after(journal, std::ios::binary | std::ios::ate);
+        REQUIRE(after.tellg() == before);                                                       //nichts abgeschnitten
+        REQUIRE(lib.findById(INT_MAX)->title == "Letzte geaendert");
+        REQUIRE(lib.findById(6)->title == "Sechs");
+        REQUIRE_FALSE(lib.findById(5).has_value());
+        REQUIRE(lib.addTrack(makeTrack("Sieben", "E", "F", 2003, "Jazz", 300)) == 7);
+    }
+
+    std::remove(csv.c_str());
+    std::remove(journal.c_str());
+}
 
 
 
 
 
+TEST_CASE("saveToCsv schreibt dieselben Zeilen wie toCsvRow", "(Test Methode saveToCsv/toCsvRow)") {
+    const std::string path = "test_writer.csv";
+
+    MusicLibrary lib;
+    for (int i = 0; i < 30000; ++i) {                                                          //mehr als ein Schreibblock
+        lib.addTrack(makeTrack("Song " + std::to_string(i), "Artist", "Album", 1900 + i % 120, "Pop", -i));
+    }
+    REQUIRE(MusicLibrary::toCsvRow(lib.listAll()[5]) == "6,Song 5,Artist,Album,1905,Pop,-5");
+    REQUIRE(lib.saveToCsv(path));
+
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    REQUIRE(line == "id,title,artist,album,year,genre,durationSec");
+    size_t n = 0;
+    while (std::getline(in, line)) {
+        REQUIRE(line == MusicLibrary::toCsvRow(lib.listAll()[n]));
+        ++n;
+    }
+    REQUIRE(n == lib.listAll().size());
+
+    std::ifstream tmp(path + ".tmp");                                                           //temporaere Datei ist weg
+    REQUIRE_FALSE(tmp.is_open());
+
+    std::remove(path.c_str());
+}
+
+
 
 
 
+TEST_CASE("saveToCsvParallel schreibt dieselbe Datei wie saveToCsv", "(Test Methode saveToCsvParallel)") {
+    const std::string seqPath = "test_save_seq.csv";
+    const std::string parPath = "test_save_par.csv";
 
+    MusicLibrary lib;
+    for (int i = 0; i < 300000; ++i) {                                                         //mehrere Runden mit je zwei Paketen
+        lib.addTrack(makeTrack("Song " + std::to_string(i), "Artist " + std::to_string(i % 50), "Album", 1950 + i % 70, "Pop", i % 400));
+    }
+    REQUIRE(lib.saveToCsv(seqPath));
+    REQUIRE(lib.saveToCsvParallel(parPath, 2));
+
+    auto readAll = [](const std::string& p) {
+        std::ifstream in(p, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    };
+    std::string seq = readAll(seqPath);
+    REQUIRE(seq.size() > 0);
+    REQUIRE(seq == readAll(parPath));                                                           //byte-genau gleich
+
+    std::remove(seqPath.c_str());
+    std::remove(parPath.c_str());
+}
+
+
+
+
+
+TEST_CASE("AutoSaver fasst Aenderungen zu einer Speicherung zusammen", "(Test Klasse AutoSaver)") {
+    const std::string path = "test_autosave.csv";
+    const std::string journal = "test_autosave.csv.journal";
+    std::remove(journal.c_str());
+    auto journalSize = [&] {
+        std::ifstream in(journal, std::ios::binary | std::ios::ate);
+        return static_cast<long long>(in.tellg());
+    };
+
+    MusicLibrary lib;
+    REQUIRE(lib.openJournal(journal, 1));
+    {
+        AutoSaver saver(lib, path, std::chrono::milliseconds(100));
+        for (int i = 0; i < 20; ++i) {                                                          //schnelle Aenderungen hintereinander
+            lib.addTrack(makeTrack("Song " + std::to_string(i), "A", "B", 2000, "Pop", 100));
+            saver.markDirty();
+        }
+
+        for (int i = 0; i < 500 && saver.status().saves == 0; ++i) {                           //auf die Sicherung warten
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        REQUIRE(saver.status().saves == 1);                                                     //nur eine Speicherung
+        REQUIRE(saver.status().lastOk);
+        REQUIRE(journalSize() == 8);                                                            //gespeicherte Eintraege sind aus dem Journal raus
+
+        lib.addTrack(makeTrack("Zuletzt", "A", "B", 2001, "Rock", 90));
+        saver.markDirty();
+    }                                                                                           //Destruktor speichert offene Aenderung
+    REQUIRE(journalSize() == 8);
+    lib.updateTrack(1, makeTrack("Nach dem Autosave", "A", "B", 2002, "Pop", 100));             //landet nur im Journal
+    REQUIRE(journalSize() > 8);
+    lib.closeJournal();
+
+    MusicLibrary loaded;
+    REQUIRE(loaded.loadFromCsv(path));
+    REQUIRE(loaded.listAll().size() == 21);
+    REQUIRE(loaded.listAll()[20].title == "Zuletzt");
+    REQUIRE(loaded.openJournal(journal));
+    REQUIRE(loaded.findById(1)->title == "Nach dem Autosave");
+    REQUIRE(loaded.listAll().size() == 21);
+
+    REQUIRE(lib.checkpointCopy(path));                                                          //ohne offenes Journal nur speichern
+    loaded.closeJournal();
+    std::remove(path.c_str());
+    std::remove(journal.c_str());
+}
+
+
+
+
+
+
+
+
+
+TEST_CASE("Spaltenspeicher behaelt listAll/findById nach Aenderungen bei", "(Test Klasse TrackColumns)") {
+    MusicLibrary lib;
+    int a = lib.addTrack(makeTrack("Song A", "Artist A", "Album A", 1990, "Pop", 100));
+    int b = lib.addTrack(makeTrack("Song B", "Artist B", "Album B", 2000, "Rock", 200));
+    int c = lib.addTrack(makeTrack("Song C", "Artist C", "Album C", 2010, "Jazz", 300));
+
+    REQUIRE(lib.updateTrack(b, makeTrack("Neu B", "Artist B", "Album B", 2001, "Rock", 210)));
+    REQUIRE(lib.deleteTrack(a));
+
+    auto list = lib.listAll();
+    REQUIRE(list.size() == 2);
+    REQUIRE(list[0].id == b);                                                                   //Reihenfolge bleibt erhalten
+    REQUIRE(list[0].title == "Neu B");
+    REQUIRE(list[1].id == c);
+
+    auto found = lib.findById(c);
+    REQUIRE(found.has_value());
+    REQUIRE(found->genre == "Jazz");
+    REQUIRE_FALSE(lib.findById(a).has_value());                                                 //geloeschter Track
+
+    int count = 0;
+    for (const MusicTrack& t : list) count += t.year > 2000;                                    //Iteration ueber die Sicht
+    REQUIRE(count == 2);
+    REQUIRE(lib.totalDurationSec() == 510);                                                     //Summe nur ueber die Dauer-Spalte
+}
+
+
+
+
+
+TEST_CASE("Interpret, Album und Genre werden per Woerterbuch gespeichert", "(Test Klasse StringDictionary)") {
+    MusicLibrary lib;
+    for (int i = 0; i < 100; ++i) {
+        lib.addTrack(makeTrack("Song " + std::to_string(i), i % 2 ? "Band X" : "Band Y", "Album",
+            2000, i % 10 ? "Rock" : "Jazz", 100));
+    }
+    int id = lib.addTrack(makeTrack("Solo", "Band Z", "Album", 2000, "Jazz", 100));
+    lib.updateTrack(id, makeTrack("Solo", "Band Z", "Album", 2000, "Blues", 100));
+
+    REQUIRE(lib.search("jazz", Field::Genre).size() == 10);                                     //Vergleich ueber die Codes
+    REQUIRE(lib.search("blue", Field::Genre).size() == 1);                                      //geaenderter Wert neu vergeben
+    REQUIRE(lib.search("band x", Field::Artist).size() == 50);
+    REQUIRE(lib.search("band", Field::Any).size() == 101);
+    REQUIRE(lib.search("Solo", Field::Any).size() == 1);                                        //Titel weiterhin pro Zeile
+
+    StringDictionary dict;
+    REQUIRE(dict.intern("Pop") == 0);
+    REQUIRE(dict.intern("Rock") == 1);
+    REQUIRE(dict.intern("Pop") == 0);                                                           //gleicher Text, gleicher Code
+    StringDictionary copy = dict;
+    dict.clear();
+    REQUIRE(copy.intern("Rock") == 1);                                                          //Kopie unabhaengig vom Original
+    REQUIRE(copy[0] == "Pop");
+}
+
+
+
+
+
+TEST_CASE("StringArena legt Texte blockweise ab und setzt in O(1) zurueck", "(Test Klasse StringArena)") {
+    StringArena arena;
+    std::string_view a = arena.store("Hallo");
+    std::string_view b = arena.store(std::string(300 * 1024, 'x'));                            //groesser als ein Block
+    std::string_view c = arena.store("Welt");
+
+    REQUIRE(a == "Hallo");
+    REQUIRE(b.size() == 300 * 1024);
+    REQUIRE(c == "Welt");                                                                       //fruehere Sichten bleiben gueltig
+    REQUIRE(arena.store("").empty());
+
+    size_t reserved = arena.bytesReserved();
+    arena.clear();
+    REQUIRE(arena.bytesUsed() == 0);
+    arena.store("Neu");
+    REQUIRE(arena.bytesReserved() == reserved);                                                 //Bloecke werden wiederverwendet
+
+    MusicLibrary lib;
+    int id = lib.addTrack(makeTrack("Alt", "A", "B", 2000, "Pop", 100));
+    MusicLibrary moved = std::move(lib);                                                        //Sichten ueberleben den Move
+    moved.updateTrack(id, makeTrack("Neuer Titel", "A", "B", 2000, "Pop", 100));
+    REQUIRE(moved.findById(id)->title == "Neuer Titel");
+    moved.clear();
+    moved.addTrack(makeTrack("Nach clear", "C", "D", 2001, "Rock", 90));
+    REQUIRE(moved.listAll()[0].title == "Nach clear");
+    REQUIRE(moved.listAll()[0].artist == "C");
+}
+
+
+
+
+
+TEST_CASE("ID-Index bleibt bei Aenderungen und verstreuten IDs konsistent", "(Test Klasse IdIndex)") {
+    const std::string path = "test_ids.csv";
+    {
+        std::ofstream out(path);
+        out << "id,title,artist,album,year,genre,durationSec\n";
+        out << "5,Fuenf,A,B,2000,Pop,100\n";
+        out << "2000000000,Gross,A,B,2000,Pop,100\n";                                          //landet in der Hash-Map
+        out << "-3,Negativ,A,B,2000,Pop,100\n";
+        out << "7,Sieben,A,B,2000,Pop,100\n";
+    }
+
+    MusicLibrary lib;
+    REQUIRE(lib.loadFromCsv(path));
+    REQUIRE(lib.findById(2000000000)->title == "Gross");
+    REQUIRE(lib.findById(-3)->title == "Negativ");
+    REQUIRE_FALSE(lib.findById(6).has_value());
+
+    REQUIRE(lib.deleteTrack(5));                                                                //spaetere Slots ruecken nach
+    REQUIRE(lib.findById(7)->title == "Sieben");
+    REQUIRE(lib.updateTrack(-3, makeTrack("Neu", "A", "B", 2000, "Pop", 100)));
+    REQUIRE(lib.findById(-3)->title == "Neu");
+
+    lib.clear();
+    REQUIRE_FALSE(lib.findById(7).has_value());                                                 //Index wird mitgeleert
+
+    std::vector<int> ids;
+    for (int i = 0; i < 5000; ++i) ids.push_back(lib.addTrack(makeTrack("T", "A", "B", 2000, "Pop", 1)));
+    for (int i = 0; i < 5000; i += 2) REQUIRE(lib.deleteTrack(ids[i]));
+    for (int i = 1; i < 5000; i += 2) REQUIRE(lib.findById(ids[i])->id == ids[i]);
+    REQUIRE(lib.listAll().size() == 2500);
+
+    std::remove(path.c_str());
+}
+
+
+
+
+
+TEST_CASE("deleteTrack markiert Grabsteine und verdichtet spaeter", "(Test Methode compact)") {
+    MusicLibrary lib;
+    lib.setCompactionRatio(1.0);                                                                //nur explizit verdichten
+    std::vector<int> ids;
+    for (int i = 0; i < 10; ++i) {
+        ids.push_back(lib.addTrack(makeTrack("Song " + std::to_string(i), "A", "B", 2000, i < 5 ? "Rock" : "Pop", 10)));
+    }
+    for (int i = 0; i < 10; i += 3) REQUIRE(lib.deleteTrack(ids[i]));                           //0, 3, 6, 9
+    REQUIRE_FALSE(lib.deleteTrack(ids[0]));                                                     //schon geloescht
+
+    auto list = lib.listAll();
+    REQUIRE(list.size() == 6);
+    REQUIRE(list[0].title == "Song 1");                                                         //Reihenfolge bleibt stabil
+    REQUIRE(list[2].title == "Song 4");
+    int n = 0;
+    for (const MusicTrack& t : list) n += t.id != ids[3];                                       //Iteration ueberspringt Grabsteine
+    REQUIRE(n == 6);
+    REQUIRE(lib.search("rock", Field::Genre).size() == 3);
+    REQUIRE(lib.search("Song", Field::Any).size() == 6);
+    REQUIRE(lib.totalDurationSec() == 60);
+    REQUIRE_FALSE(lib.findById(ids[6]).has_value());
+
+    REQUIRE(lib.saveToCsv("test_tomb.csv"));                                                   //Speichern ohne Grabsteine
+    REQUIRE(lib.saveSnapshot("test_tomb.snap"));
+    MusicLibrary fromCsv, fromSnap;
+    REQUIRE(fromCsv.loadFromCsv("test_tomb.csv"));
+    REQUIRE(fromSnap.loadSnapshot("test_tomb.snap"));
+    REQUIRE(fromCsv.listAll().size() == 6);
+    REQUIRE(fromSnap.listAll().size() == 6);
+    REQUIRE(fromSnap.listAll()[1].title == "Song 2");
+    std::remove("test_tomb.csv");
+    std::remove("test_tomb.snap");
+
+    lib.compact();
+    REQUIRE(lib.listAll().size() == 6);
+    REQUIRE(lib.listAll()[5].title == "Song 8");
+    REQUIRE(lib.findById(ids[8])->title == "Song 8");                                           //Index nach dem Verdichten
+
+    lib.setCompactionRatio(0.25);
+    for (int i = 0; i < 20000; ++i) lib.addTrack(makeTrack("Viele", "A", "B", 2000, "Pop", 1));
+    for (int id = ids.back() + 1; id < ids.back() + 20001; id += 2) REQUIRE(lib.deleteTrack(id));
+    REQUIRE(lib.listAll().size() == 10006);
+}
+
+
+
+
+
+TEST_CASE("Suche ohne Kopien ueber Slots und Besucher", "(Test Methode forEachMatch)") {
+    MusicLibrary lib;
+    for (int i = 0; i < 50; ++i) {
+        lib.addTrack(makeTrack("Song " + std::to_string(i), "Band", "Album", 2000 + i % 5, i % 2 ? "Rock" : "Pop", 60));
+    }
+
+    std::vector<std::size_t> slots = lib.searchSlots("rock", Field::Genre);
+    REQUIRE(slots.size() == 25);
+    for (std::size_t slot : slots) REQUIRE(lib.viewAt(slot).genre == "Rock");                  //Sicht statt Kopie
+
+    int hits = 0;
+    long long seconds = 0;
+    lib.forEachMatch("2003", Field::Year, [&](const MusicTrackView& v) {                        //Besucher ohne Rueckgabe
+        ++hits;
+        seconds += v.durationSec;
+    });
+    REQUIRE(hits == 10);
+    REQUIRE(seconds == 600);
+
+    int seen = 0;
+    lib.forEachMatch("song", Field::Title, [&](const MusicTrackView&) { return ++seen < 3; });  //false bricht ab
+    REQUIRE(seen == 3);
+
+    REQUIRE(lib.search("rock", Field::Genre).size() == slots.size());                           //Kopie-API als Huelle
+}
+
+
+
+
+
+TEST_CASE("Seitenweises Auflisten und Suchen mit Fortsetzungs-Token", "(Test Methode listPage/searchNext)") {
+    MusicLibrary lib;
+    for (int i = 0; i < 120; ++i) {
+        lib.addTrack(makeTrack("Song " + std::to_string(i), "Band", "Album", 2000, i % 3 ? "Pop" : "Rock", 60));
+    }
+
+    TrackPage first = lib.listPage(0, 50);
+    REQUIRE(first.tracks.size() == 50);
+    REQUIRE(first.more);
+    TrackPage last = lib.listPage(100, 50);
+    REQUIRE(last.tracks.size() == 20);
+    REQUIRE_FALSE(last.more);
+    REQUIRE(last.tracks[0].title == "Song 100");
+
+    lib.deleteTrack(first.tracks[0].id);                                                        //Token bleibt ohne Verdichten gueltig
+    TrackPage second;
+    REQUIRE(lib.listNext(first.next, 50, second));
+    REQUIRE(second.tracks[0].title == "Song 50");
+
+    std::vector<int> ids;                                                                       //alle Rock-Treffer in Seiten zu 7
+    TrackPage page;
+    PageToken token;
+    do {
+        REQUIRE(lib.searchNext("rock", Field::Genre, token, 7, page));
+        for (const auto& t : page.tracks) ids.push_back(t.id);
+        token = page.next;
+    } while (page.more);
+    REQUIRE(ids.size() == 39);                                                                  //40 minus der geloeschte Song 0
+    REQUIRE(lib.searchPage("rock", Field::Genre, 35, 7).tracks.size() == 4);
+    REQUIRE(lib.searchPage("rock", Field::Genre, 31, 7).more);                                  //ein Treffer folgt noch
+
+    lib.compact();
+    REQUIRE_FALSE(lib.listNext(first.next, 50, second));                                        //nach compact ungueltig
+    REQUIRE(lib.listNext(PageToken{}, 50, second));                                             //Standard-Token immer gueltig
+
+    first = lib.listPage(0, 50);
+    REQUIRE(lib.listNext(first.next, 50, second));
+    for (int i = 0; i < 40; ++i) REQUIRE(lib.deleteTrack(second.tracks[0].id + i));             //Loeschen verdichtet automatisch ...
+    REQUIRE(lib.listAll().size() == 79);
+    REQUIRE_FALSE(lib.listNext(first.next, 50, second));                                        //... und macht das Token ungueltig
+    REQUIRE_FALSE(lib.searchNext("rock", Field::Genre, first.next, 7, page));
+}
+
+
+
+
+
+TEST_CASE("addTracks fuegt viele Tracks mit fortlaufenden IDs hinzu", "(Test Methode addTracks)") {
+    MusicLibrary lib;
+    lib.addTrack(makeTrack("Vorher", "A", "B", 2000, "Pop", 10));
+
+    std::vector<MusicTrack> batch;
+    for (int i = 0; i < 200000; ++i) {
+        batch.push_back(makeTrack("  Song " + std::to_string(i) + "\n", " Band ", "Album\r", 2000, "Pop ", 10));
+    }
+    int first = lib.addTracks(std::move(batch), 4);                                             //parallel bereinigt
+
+    REQUIRE(first == 2);
+    REQUIRE(lib.listAll().size() == 200001);
+    auto t = lib.findById(first + 1234);
+    REQUIRE(t.has_value());
+    REQUIRE(t->title == "Song 1234");                                                           //wie sanitize: getrimmt
+    REQUIRE(t->artist == "Band");
+    REQUIRE(t->album == "Album");
+    REQUIRE(lib.addTrack(makeTrack("Danach", "A", "B", 2000, "Pop", 10)) == 200002);            //IDs laufen weiter
+
+    MusicTrack moved = makeTrack(" Mitte\r\nZeile ", "A", "B", 2000, "Pop", 10);
+    int id = lib.addTrack(std::move(moved));
+    REQUIRE(lib.findById(id)->title == MusicLibrary::sanitize(" Mitte\r\nZeile "));
+    REQUIRE(lib.addTracks({}) == id + 1);                                                       //leerer Batch
+}
+
+
+
+
+
+TEST_CASE("Suche ueber gefaltete Schattenspalten", "(Test Methode search)") {
+    MusicLibrary lib;
+    int id = lib.addTrack(makeTrack("Hello WORLD", "The BAND", "Greatest Hits", 1999, "Hard Rock", 200));
+    lib.addTrack(makeTrack("kleiner titel", "band", "hits", 2000, "rock", 100));
+
+    REQUIRE(lib.search("WORLD", Field::Title).size() == 1);                                     //Suchbegriff wird gefaltet
+    REQUIRE(lib.search("o w", Field::Title).size() == 1);
+    REQUIRE(lib.search("Band", Field::Artist).size() == 2);
+    REQUIRE(lib.search("HITS", Field::Any).size() == 2);
+    REQUIRE(lib.search("1999", Field::Any).size() == 1);
+    REQUIRE(lib.search("01999", Field::Year).empty());                                          //wie to_string-Vergleich
+    REQUIRE(lib.search("", Field::Title).size() == 2);
+
+    lib.updateTrack(id, makeTrack("Neuer TITEL", "The BAND", "Greatest Hits", 1999, "Hard Rock", 200));
+    REQUIRE(lib.search("world", Field::Title).empty());                                         //Schattenspalte mit aktualisiert
+    REQUIRE(lib.search("titel", Field::Title).size() == 2);
+    REQUIRE(lib.findById(id)->title == "Neuer TITEL");                                          //Original bleibt unveraendert
+}
+
+
+
+
+
+TEST_CASE("Teilstring-Suche findet Treffer in langen Titeln an jeder Position", "(Test Methode search)") {
+    const std::string filler = "abcdefghijklmnopqrstuvwxyz0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    MusicLibrary lib;
+    for (size_t pos = 0; pos <= 80; ++pos) {                                                    //Treffer am Anfang, in der Mitte, am Ende
+        std::string title = (filler + filler).substr(0, pos) + "NeEdLe" + filler.substr(0, 80 - pos);
+        lib.addTrack(makeTrack(title, "A", "B", 2000, "Pop", 1));
+    }
+    lib.addTrack(makeTrack(filler + filler + "needl", "A", "B", 2000, "Pop", 1));              //nur ein Teil am Ende
+
+    REQUIRE(lib.search("needle", Field::Title).size() == 81);                                   //SIMD-Bloecke und Rest
+    REQUIRE(lib.search("NEEDLE", Field::Any).size() == 81);
+    REQUIRE(lib.search("eedl", Field::Title).size() == 82);
+    REQUIRE(lib.search("n", Field::Title).size() == 82);
+    REQUIRE(lib.search("z0123", Field::Title).size() == 82);                                    //Buchstaben und Ziffern gemischt
+    REQUIRE(lib.search(filler + filler + "needle", Field::Title).empty());
+}
+
+
+
+
+
+TEST_CASE("Trigramm-Index liefert dieselben Treffer wie der volle Scan", "(Test Methode search)") {
+    MusicLibrary plain, indexed;
+    indexed.enableTrigramIndex();                                                               //vor dem Befuellen einschalten
+    const char* words[] = { "Sun", "Moon", "Star", "Rain", "Fire" };
+    for (int i = 0; i < 300; ++i) {
+        MusicTrack t = makeTrack(std::string(words[i % 5]) + " Song " + std::to_string(i),
+            std::string("Band ") + words[(i / 5) % 5], "Album " + std::to_string(i % 7),
+            1990 + i % 20, i % 2 ? "Rock" : "Jazz", 100 + i);
+        plain.addTrack(t);
+        indexed.addTrack(t);
+    }
+    indexed.setCompactionRatio(1.0);                                                            //Grabsteine bleiben zunaechst liegen
+    plain.setCompactionRatio(1.0);
+
+    auto same = [&](const std::string& q, Field by) {
+        auto a = plain.search(q, by);
+        auto b = indexed.search(q, by);
+        REQUIRE(a.size() == b.size());
+        for (size_t i = 0; i < a.size(); ++i) REQUIRE(a[i].id == b[i].id);
+    };
+    auto check = [&]() {
+        for (const char* q : { "song 1", "MOON", "oon s", "band sun", "rock", "jazz", "um 3", "xyz",
+                               "s", "so", "1999", "" }) {                                       //auch unter 3 Zeichen
+            same(q, Field::Title);
+            same(q, Field::Artist);
+            same(q, Field::Album);
+            same(q, Field::Genre);
+            same(q, Field::Any);
+        }
+    };
+    check();
+
+    for (int id = 1; id <= 300; id += 7) {
+        MusicTrack t = makeTrack("Renamed " + std::to_string(id), "Neue Band", "Album X", 2001, "Pop", 1);
+        plain.updateTrack(id, t);
+        indexed.updateTrack(id, t);
+    }
+    for (int id = 2; id <= 300; id += 5) {
+        plain.deleteTrack(id);
+        indexed.deleteTrack(id);
+    }
+    check();                                                                                    //nach Update und Loeschen
+    same("renamed", Field::Title);
+    same("neue", Field::Artist);
+
+    for (int round = 0; round < 100; ++round) {                                                 //hin und her umbenennen ohne Abfrage dazwischen
+        for (int id = 3; id <= 300; id += 11) {
+            MusicTrack t = makeTrack((round % 2 ? "Sun Song " : "Sun Dance ") + std::to_string(round),
+                "Band Moon", "Album 1", 2002, "Rock", 2);
+            plain.updateTrack(id, t);
+            indexed.updateTrack(id, t);
+        }
+    }
+    {
+        const auto expected = plain.search("sun song", Field::Title).size();                    //Suchen aendern den Index nicht (parallel lesbar)
+        size_t counts[2] = { 0, 0 };
+        std::thread other([&] { counts[0] = indexed.search("sun song", Field::Title).size(); });
+        counts[1] = indexed.search("sun song", Field::Title).size();
+        other.join();
+        REQUIRE(counts[0] == expected);
+        REQUIRE(counts[1] == expected);
+    }
+    check();
+    same("sun dance 98", Field::Title);
+    same("sun song 99", Field::Title);
+    same("song 9", Field::Title);
+
+    indexed.compact();
+    plain.compact();
+    check();                                                                                    //Slots nach Verdichten neu
+    REQUIRE(indexed.trigramIndexEnabled());
+    indexed.enableTrigramIndex(false);
+    check();
+}
+
+
+
+
+
+TEST_CASE("Vorschlaege fuer ein Praefix nach Anzahl Tracks", "(Test Methode suggest)") {
+    MusicLibrary lib;
+    lib.addTrack(makeTrack("Hello", "Queen", "A", 2000, "Rock", 1));
+    lib.addTrack(makeTrack("Help", "Queen", "A", 2000, "Rock", 1));
+    int id = lib.addTrack(makeTrack("hello", "QUEEN", "B", 2000, "Rock", 1));                 //gleiche Werte, andere Schreibweise
+    lib.addTrack(makeTrack("Yesterday", "Queens of the Stone Age", "C", 2000, "Pop", 1));
+    lib.addTrack(makeTrack("Heroes", "Bowie", "D", 2000, "Rock", 1));
+
+    auto s = lib.suggest("que", Field::Artist, 5);
+    REQUIRE(s.size() == 2);
+    REQUIRE(s[0].text == "Queen");                                                              //haeufigste Schreibweise
+    REQUIRE(s[0].count == 3);
+    REQUIRE(s[1].text == "Queens of the Stone Age");
+
+    s = lib.suggest("HE", Field::Title, 10);
+    REQUIRE(s.size() == 3);
+    REQUIRE(s[0].text == "Hello");
+    REQUIRE(s[0].count == 2);
+    REQUIRE(s[1].text == "Help");                                                               //Gleichstand: alphabetisch
+    REQUIRE(s[2].text == "Heroes");
+    REQUIRE(lib.suggest("he", Field::Title, 1).size() == 1);                                    //nur die k besten
+    REQUIRE(lib.suggest("x", Field::Title).empty());
+    REQUIRE(lib.suggest("", Field::Genre).size() == 2);
+    REQUIRE(lib.suggest("r", Field::Year).empty());
+
+    lib.updateTrack(id, makeTrack("Heaven", "Bowie", "B", 2000, "Rock", 1));                    //Aenderung wird nachgefuehrt
+    lib.addTrack(makeTrack("Hero", "Bowie", "E", 2000, "Rock", 1));
+    s = lib.suggest("he", Field::Title, 10);
+    REQUIRE(s.size() == 5);
+    REQUIRE(s[0].text == "Heaven");
+    REQUIRE(s[0].count == 1);
+    REQUIRE(lib.suggest("queen", Field::Artist)[0].count == 2);
+    REQUIRE(lib.suggest("bow", Field::Artist)[0].count == 3);
+
+    lib.deleteTrack(id);
+    lib.compact();
+    REQUIRE(lib.suggest("heav", Field::Title).empty());
+    REQUIRE(lib.suggest("bow", Field::Artist)[0].count == 2);
+    lib.deleteTrack(1);
+    REQUIRE(lib.suggest("hello", Field::Title).empty());                                        //geloescht zaehlt nicht
+
+    const auto all = lib.listAll();                                                             //viele Titelaenderungen vor der naechsten Abfrage
+    for (int round = 0; round < 20; ++round) {
+        for (const MusicTrack& old : all) {
+            MusicTrack t = old;
+            t.title = (round % 2 ? "Zebra " : "Anthem ") + std::to_string(t.id);
+            lib.updateTrack(t.id, t);
+        }
+    }
+    REQUIRE(lib.suggest("he", Field::Title).empty());
+    REQUIRE(lib.suggest("zebra", Field::Title).size() == all.size());
+    REQUIRE(lib.suggest("anthem", Field::Title).empty());
+    MusicTrack last = all[all.size() - 1];
+    last.title = "Anthem";
+    lib.updateTrack(last.id, last);
+    REQUIRE(lib.suggest("an", Field::Title)[0].text == "Anthem");
+    REQUIRE(lib.suggest("zeb", Field::Title).size() == all.size() - 1);
+
+    last.title = "Zugabe";                                                                      //zwei Leser ziehen die Ordnungen gleichzeitig nach
+    last.artist = "Zappa";
+    lib.updateTrack(last.id, last);
+    std::vector<Suggestion> found[2];
+    std::thread other([&] {
+        found[0] = lib.suggest("zu", Field::Title);
+        found[0].push_back(lib.suggest("zap", Field::Artist).at(0));
+    });
+    found[1] = lib.suggest("zu", Field::Title);
+    found[1].push_back(lib.suggest("zap", Field::Artist).at(0));
+    other.join();
+    for (const auto& f : found) {
+        REQUIRE(f.size() == 2);
+        REQUIRE(f[0].text == "Zugabe");
+        REQUIRE(f[1].text == "Zappa");
+    }
+}
+
+
+
+
+
+TEST_CASE("Bereichsabfragen ueber Jahr und Dauer", "(Test Methode searchRange)") {
+    MusicLibrary lib;
+    for (int i = 0; i < 100; ++i) {
+        lib.addTrack(makeTrack("T" + std::to_string(i), "A", "B", 1950 + (i * 37) % 60, "Pop", 60 + (i * 53) % 600));
+    }
+    auto brute = [&](RangeField by, int lo, int hi) {
+        size_t n = 0;
+        for (const auto& t : lib.listAll()) {
+            int v = by == RangeField::Year ? t.year : t.durationSec;
+            if (v >= lo && v <= hi) ++n;
+        }
+        return n;
+    };
+
+    auto hits = lib.searchRange(RangeField::Year, 1990, 1999);
+    REQUIRE(hits.size() == brute(RangeField::Year, 1990, 1999));
+    for (size_t i = 1; i < hits.size(); ++i) {
+        REQUIRE(hits[i - 1].year <= hits[i].year);                                              //aufsteigend nach Wert
+        if (hits[i - 1].year == hits[i].year) REQUIRE(hits[i - 1].id < hits[i].id);
+    }
+    REQUIRE(lib.searchRange(RangeField::Duration, 361, INT_MAX).size() == brute(RangeField::Duration, 361, INT_MAX));
+    REQUIRE(lib.searchRange(RangeField::Year, 2000, 1990).empty());                             //leerer Bereich
+    REQUIRE(lib.searchRange(RangeField::Year, 1951, 1951).size() == lib.search("1951", Field::Year).size());
+
+    lib.updateTrack(1, makeTrack("T0", "A", "B", 1995, "Pop", 5000));                           //Index wird nachgefuehrt
+    lib.deleteTrack(2);
+    lib.addTrack(makeTrack("Neu", "A", "B", 1995, "Pop", 10));
+    REQUIRE(lib.searchRange(RangeField::Year, 1990, 1999).size() == brute(RangeField::Year, 1990, 1999));
+    REQUIRE(lib.searchRange(RangeField::Duration, 4000, 6000).size() == 1);
+    REQUIRE(lib.searchRange(RangeField::Duration, 0, 59).size() == 1);
+    REQUIRE(lib.search("1995", Field::Year).size() == brute(RangeField::Year, 1995, 1995));
+
+    lib.compact();
+    REQUIRE(lib.searchRange(RangeField::Year, INT_MIN, INT_MAX).size() == 100);
+    REQUIRE(lib.searchPage("1995", Field::Year, 1, 100).tracks.size() == brute(RangeField::Year, 1995, 1995) - 1);
+
+    auto sorted = [&](RangeField by) {
+        auto all = lib.searchRange(by, INT_MIN, INT_MAX);
+        for (size_t i = 1; i < all.size(); ++i) {
+            int a = by == RangeField::Year ? all[i - 1].year : all[i - 1].durationSec;
+            int b = by == RangeField::Year ? all[i].year : all[i].durationSec;
+            REQUIRE((a < b || (a == b && all[i - 1].id < all[i].id)));
+        }
+        return all.size();
+    };
+    const auto ids = lib.listAll();
+    for (int round = 0; round < 3; ++round) {                                                   //viele Aenderungen zwischen zwei Abfragen
+        for (size_t i = 0; i < ids.size(); i += 3) {
+            MusicTrack t = ids[i];
+            t.year = 1900 + static_cast<int>((i * 7 + round * 11) % 120);
+            t.durationSec = static_cast<int>((i * 13 + round) % 700);
+            lib.updateTrack(t.id, t);
+        }
+        REQUIRE(sorted(RangeField::Year) == 100);
+        REQUIRE(sorted(RangeField::Duration) == 100);
+        REQUIRE(lib.searchRange(RangeField::Year, 1950, 1979).size() == brute(RangeField::Year, 1950, 1979));
+    }
+    for (int i = 0; i < 250; ++i) {                                                             //mehr Aenderungen als Slots
+        MusicTrack t = ids[0];
+        t.year = 1800 + i;
+        lib.updateTrack(t.id, t);
+    }
+    REQUIRE(sorted(RangeField::Year) == 100);
+    REQUIRE(lib.searchRange(RangeField::Year, 2049, 2049).size() == 1);
+
+    MusicTrack moved = ids[1];                                                                  //zwei Leser ziehen die Ordnung gleichzeitig nach
+    moved.year = 1700;
+    moved.durationSec = 9999;
+    lib.updateTrack(moved.id, moved);
+    size_t found[2] = { 0, 0 };
+    std::thread other([&] { found[0] = lib.searchRange(RangeField::Year, 1700, 1700).size(); });
+    found[1] = lib.searchRange(RangeField::Year, 1700, 1700).size();
+    other.join();
+    REQUIRE(found[0] == 1);
+    REQUIRE(found[1] == 1);
+    REQUIRE(lib.searchRange(RangeField::Duration, 9999, 9999).size() == 1);
+}
+
+
+
+
+
+TEST_CASE("Zusammengesetzte Abfragen und Abfrage-Text", "(Test Methode query)") {
+    MusicLibrary lib;
+    const char* artists[] = { "Queen", "Queens of the Stone Age", "Bowie", "ABBA" };
+    const char* genres[] = { "Pop", "Rock", "Jazz" };
+    for (int i = 0; i < 400; ++i) {
+        lib.addTrack(makeTrack(i % 10 == 0 ? "Intro" : "Song " + std::to_string(i), artists[i % 4],
+            "Album " + std::to_string(i % 9), 1970 + i % 50, genres[(i / 4) % 3], 60 + (i * 37) % 400));
+    }
+    lib.deleteTrack(5);
+    lib.updateTrack(7, makeTrack("Intro", "Bowie", "X", 2001, "Pop", 500));
+
+    // Vergleich mit einer direkten Auswertung ueber alle Tracks
+    auto brute = [&](auto pred) {
+        std::vector<int> ids;
+        for (const auto& t : lib.listAll()) if (pred(t)) ids.push_back(t.id);
+        return ids;
+    };
+    auto ids = [&](const Query& q) {
+        std::vector<int> out;
+        for (const auto& t : lib.query(q)) out.push_back(t.id);
+        return out;
+    };
+    auto parsed = [&](const char* text) {
+        auto q = Query::parse(text);
+        REQUIRE(q.has_value());
+        return ids(*q);
+    };
+    auto lower = [](std::string s) { for (auto& c : s) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c))); return s; };
+
+    for (bool trigrams : { false, true }) {
+        lib.enableTrigramIndex(trigrams);                                                       //mit und ohne Index gleich
+
+        auto expected = brute([&](const MusicTrack& t) {
+            return lower(t.artist).find("queen") != std::string::npos && t.year >= 2000 && t.genre == "Pop";
+        });
+        REQUIRE(!expected.empty());
+        REQUIRE(parsed("artist:queen AND year >= 2000 AND genre = pop") == expected);
+        REQUIRE(ids(Query::contains(Field::Artist, "QUEEN") && Query::range(RangeField::Year, 2000, INT_MAX) &&
+            Query::equals(Field::Genre, "Pop")) == expected);
+
+        expected = brute([&](const MusicTrack& t) {
+            return (t.title == "Intro" || t.durationSec < 100) && !(t.artist == "Bowie");
+        });
+        REQUIRE(parsed("(titel = intro || dauer < 100) && NOT artist = bowie") == expected);
+        REQUIRE(parsed("(title=\"intro\" OR duration<100) AND artist != Bowie") == expected);
+
+        expected = brute([&](const MusicTrack& t) { return t.year == 1999 || t.title == "Song 123"; });
+        REQUIRE(parsed("year:1999 OR title:\"song 123\"") == expected);
+        REQUIRE(parsed("1999 or \"song 123\"") == brute([&](const MusicTrack& t) {          //ohne Feld: alle Felder
+            return t.year == 1999 || lower(t.title).find("song 123") != std::string::npos ||
+                lower(t.album).find("1999") != std::string::npos;
+        }));
+
+        expected = brute([&](const MusicTrack& t) { return t.genre == "Jazz" && t.year > 2015 && t.year <= 2018; });
+        REQUIRE(parsed("genre=jazz and jahr>2015 and jahr<=2018") == expected);
+        REQUIRE(parsed("not not genre:rock").size() == brute([&](const MusicTrack& t) { return t.genre == "Rock"; }).size());
+    }
+    REQUIRE(lib.query(Query::allOf({})).size() == lib.listAll().size());                        //leeres AND: alles
+    REQUIRE(lib.query(Query::anyOf({})).empty());
+    REQUIRE(lib.query(Query::contains(Field::Year, "01999")).empty());
+
+    std::string error;
+    REQUIRE_FALSE(Query::parse("artist:queen AND", &error).has_value());                        //Fehler mit Meldung
+    REQUIRE(!error.empty());
+    REQUIRE_FALSE(Query::parse("(genre:pop", &error).has_value());
+    REQUIRE_FALSE(Query::parse("laenge > 3", &error).has_value());
+    REQUIRE(error.find("laenge") != std::string::npos);
+    REQUIRE_FALSE(Query::parse("artist < x").has_value());
+    REQUIRE_FALSE(Query::parse("year >= zwei").has_value());
+    REQUIRE_FALSE(Query::parse("title:\"offen").has_value());
+    REQUIRE_FALSE(Query::parse("pop )").has_value());
+}
+
+
+
+
+
+TEST_CASE("Parallele Suche liefert dieselben Treffer in derselben Reihenfolge", "(Test Methode search)") {
+    MusicLibrary lib;
+    std::vector<MusicTrack> batch;
+    for (int i = 0; i < 100000; ++i) {
+        batch.push_back(makeTrack("Song " + std::to_string(i), i % 7 == 0 ? "Queen" : "Band " + std::to_string(i % 13),
+            "Album", 1950 + i % 70, i % 3 ? "Rock" : "Pop", 60 + i % 500));
+    }
+    lib.addTracks(std::move(batch));
+    lib.setCompactionRatio(1.0);
+    for (int id = 1; id <= 100000; id += 11) lib.deleteTrack(id);                               //Grabsteine ueberspringen
+
+    auto ids = [](const std::vector<MusicTrack>& tracks) {
+        std::vector<int> out;
+        for (const auto& t : tracks) out.push_back(t.id);
+        return out;
+    };
+    auto run = [&]() {
+        std::vector<std::vector<int>> r;
+        r.push_back(ids(lib.search("99", Field::Any)));
+        r.push_back(ids(lib.search("queen", Field::Artist)));
+        r.push_back(ids(lib.search("song 12", Field::Title)));
+        r.push_back(ids(lib.searchPage("7", Field::Any, 1000, 50).tracks));                     //Abbruch nach einer Seite
+        r.push_back(ids(lib.query(*Query::parse("artist:queen AND NOT genre = pop"))));
+        return r;
+    };
+
+    lib.setParallelSearch(1);
+    auto sequential = run();
+    lib.setParallelSearch(4, 0);                                                                //auch auf einem Kern
+    REQUIRE(run() == sequential);
+    lib.enableTrigramIndex();
+    REQUIRE(run() == sequential);
+    REQUIRE(!sequential[0].empty());
+    REQUIRE(sequential[3].size() == 50);
+
+    lib.enableTrigramIndex(false);
+    size_t seen = 0;
+    lib.forEachMatch("song", Field::Title, [&](const MusicTrackView&) { return ++seen < 10; });
+    REQUIRE(seen == 10);                                                                        //Besucher bricht ab
+    REQUIRE_THROWS(lib.forEachMatch("song", Field::Title, [](const MusicTrackView&) {
+        throw std::runtime_error("Abbruch");                                                    //Ausnahme im Besucher
+    }));
+}